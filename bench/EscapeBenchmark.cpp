@@ -0,0 +1,135 @@
+// Escaping throughput benchmark: per-character switch vs. Escape (vectorized
+// run scanning). Build and run with `make bench`; pass a file to use it as
+// the corpus instead of the generated one.
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "Escape.h"
+
+namespace {
+
+std::string naiveEscape(const std::string& input, Escape::Format format) {
+    std::string output;
+    output.reserve(input.size());
+
+    for (char c : input) {
+        switch (format) {
+            case Escape::Format::JSON:
+                switch (c) {
+                    case '\"': output += "\\\""; break;
+                    case '\\': output += "\\\\"; break;
+                    case '\n': output += "\\n"; break;
+                    case '\t': output += "\\t"; break;
+                    default: output += c; break;
+                }
+                break;
+            case Escape::Format::XML:
+                switch (c) {
+                    case '&': output += "&amp;"; break;
+                    case '<': output += "&lt;"; break;
+                    case '>': output += "&gt;"; break;
+                    case '\"': output += "&quot;"; break;
+                    case '\'': output += "&apos;"; break;
+                    default: output += c; break;
+                }
+                break;
+            case Escape::Format::CSV:
+                output += c;
+                if (c == '\"') {
+                    output += '\"';
+                }
+                break;
+            case Escape::Format::HTML:
+                switch (c) {
+                    case '&': output += "&amp;"; break;
+                    case '<': output += "&lt;"; break;
+                    case '>': output += "&gt;"; break;
+                    case ' ': output += "&nbsp;"; break;
+                    case '\n': output += "<br>"; break;
+                    default: output += c; break;
+                }
+                break;
+        }
+    }
+
+    return output;
+}
+
+// Source-like text: mostly identifiers and punctuation, a few quotes
+std::string generateCorpus(size_t size) {
+    static const char* const lines[] = {
+        "    int result = compute(value, offset) + 42;\n",
+        "    // Process the \"next\" chunk of input\n",
+        "    if (count > limit && flags & MASK) {\n",
+        "        std::string name = \"identifier_with_long_name\";\n",
+        "        return buffer[index] << shift;\n",
+        "    }\n",
+    };
+    std::string corpus;
+    corpus.reserve(size);
+    for (size_t i = 0; corpus.size() < size; ++i) {
+        corpus += lines[i % (sizeof(lines) / sizeof(lines[0]))];
+    }
+    return corpus;
+}
+
+template <typename Fn>
+double measure(const std::string& corpus, int iterations, Fn escapeFn) {
+    size_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        checksum += escapeFn(corpus).size();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    if (checksum == 0) {
+        std::printf("(empty output)\n");
+    }
+    return (static_cast<double>(corpus.size()) * iterations) / (1024.0 * 1024.0) / seconds;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string corpus;
+    if (argc > 1) {
+        std::ifstream file(argv[1], std::ios::binary);
+        if (!file) {
+            std::fprintf(stderr, "Could not open %s\n", argv[1]);
+            return 1;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        corpus = buffer.str();
+    } else {
+        corpus = generateCorpus(8 * 1024 * 1024);
+    }
+
+    const int iterations = static_cast<int>(256 * 1024 * 1024 / (corpus.size() + 1)) + 1;
+    const struct {
+        const char* name;
+        Escape::Format format;
+    } formats[] = {
+        {"json", Escape::Format::JSON},
+        {"xml", Escape::Format::XML},
+        {"csv", Escape::Format::CSV},
+        {"html", Escape::Format::HTML},
+    };
+
+    std::printf("corpus: %zu bytes, %d iterations\n", corpus.size(), iterations);
+    std::printf("%-6s %12s %12s %8s\n", "format", "naive MB/s", "escape MB/s", "speedup");
+
+    for (const auto& entry : formats) {
+        Escape::Format format = entry.format;
+        double naive = measure(corpus, iterations,
+                               [format](const std::string& s) { return naiveEscape(s, format); });
+        double fast = measure(corpus, iterations,
+                              [format](const std::string& s) { return Escape::escape(s, format); });
+        std::printf("%-6s %12.1f %12.1f %7.2fx\n", entry.name, naive, fast, fast / naive);
+    }
+
+    return 0;
+}
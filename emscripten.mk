@@ -3,16 +3,38 @@ CXXFLAGS = -std=c++17 -O2 -s WASM=1 -s ALLOW_MEMORY_GROWTH=1 -s EXPORTED_RUNTIME
 SRCS = src/wasm_bindings.cpp \
        src/Lexer.cpp \
        src/Token.cpp \
+       src/TokenFilter.cpp \
        src/LanguageConfig.cpp \
        src/SymbolTable.cpp \
+       src/SymbolTableBuilder.cpp \
+       src/ProjectSymbolTable.cpp \
        src/ExportFormatter.cpp \
+       src/OutputSink.cpp \
+       src/BinaryTokenFormat.cpp \
+       src/HtmlPagesExporter.cpp \
+       src/MappedFile.cpp \
+       src/ByteScan.cpp \
+       src/Escape.cpp \
+       src/ThreadPool.cpp \
+       src/TeeWriter.cpp \
+       src/DatasetWriter.cpp \
+       src/Extractor.cpp \
+       src/PatternMatcher.cpp \
+       src/CodeSearch.cpp \
+       src/TokenQuery.cpp \
+       src/BracketIndex.cpp \
+       src/ScopeIndex.cpp \
+       src/SymbolSearchIndex.cpp \
+       src/XrefIndex.cpp \
+       src/TagFile.cpp \
+       src/BloomIndex.cpp \
        src/ConfigLoader.cpp \
        src/LanguagePlugin.cpp
 OBJS = $(SRCS:.cpp=.wasm.o)  # Use .wasm.o to avoid conflicts with regular .o files
 TARGET = web/lex.js
 
 # Additional flags for the final linking step
-EMFLAGS = -s EXPORTED_FUNCTIONS=['_tokenizeString','_getLanguageNames','_registerLanguageConfig','_initModule'] \
+EMFLAGS = -s EXPORTED_FUNCTIONS=['_tokenizeString','_tokenizeStringColumnar','_getLanguageNames','_registerLanguageConfig','_initModule'] \
           -s EXPORT_NAME="LexModule" \
           -s MODULARIZE=1 \
           -s INVOKE_RUN=1 \
@@ -0,0 +1,511 @@
+#include "BinaryTokenFormat.h"
+#include "Varint.h"
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+const char MAGIC[4] = {'L', 'X', 'T', 'K'};
+const size_t HEADER_SIZE = 12;
+const size_t FOOTER_FIELDS = 13;
+const size_t FOOTER_SIZE = FOOTER_FIELDS * 8 + 8;
+const std::string EMPTY_STRING;
+
+// Pad the output to an 8-byte boundary so fixed-width sections stay aligned
+void padTo8(OutputSink& sink, size_t base) {
+    static const char zeros[8] = {0};
+    size_t misalignment = (sink.bytesWritten() - base) % 8;
+    if (misalignment != 0) {
+        sink.write(zeros, 8 - misalignment);
+    }
+}
+
+// Binary writer: positions are streamed as tokens arrive, the fixed-width
+// columns and the string table are kept until the export finishes
+class BinaryTokenWriter : public TokenWriter {
+private:
+    uint32_t blockSize;
+    size_t base;
+
+    std::vector<uint8_t> types;
+    std::vector<uint16_t> attributes;
+    std::vector<uint32_t> lexemes;
+    std::vector<std::pair<uint32_t, uint32_t>> fileRuns;
+    std::vector<std::pair<uint32_t, uint32_t>> scopes;
+    std::vector<uint64_t> blocks;
+
+    std::unordered_map<std::string, uint32_t> stringIds;
+    std::vector<const std::string*> strings;
+
+    size_t previousOffset;
+    int previousLine;
+    std::string scratch;
+    std::string lastFilename;
+
+    uint32_t intern(const std::string& text) {
+        auto it = stringIds.find(text);
+        if (it != stringIds.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(strings.size());
+        auto inserted = stringIds.emplace(text, id).first;
+        strings.push_back(&inserted->first);
+        return id;
+    }
+
+    size_t relativeOffset() const { return sink.bytesWritten() - base; }
+
+public:
+    BinaryTokenWriter(OutputSink& sink, ExportFields fields, uint32_t blockSize)
+        : TokenWriter(sink, fields), blockSize(blockSize), base(0), previousOffset(0), previousLine(0) {}
+
+protected:
+    void writeHeader() override {
+        base = sink.bytesWritten();
+        std::string header(MAGIC, 4);
+        appendU16(header, BinaryTokenFormat::VERSION);
+        appendU16(header, 0);
+        appendU32(header, blockSize);
+        sink.write(header);
+    }
+
+    void writeToken(const Token& token) override {
+        if (tokenCount % blockSize == 0) {
+            blocks.push_back(relativeOffset());
+            previousOffset = 0;
+            previousLine = 0;
+        }
+
+        // Position record
+        scratch.clear();
+        appendVarint(scratch, token.location.offset - previousOffset);
+        appendVarint(scratch, zigzagEncode(static_cast<int64_t>(token.location.line) - previousLine));
+        appendVarint(scratch, static_cast<uint64_t>(std::max(token.location.column, 0)));
+        sink.write(scratch);
+        previousOffset = token.location.offset;
+        previousLine = token.location.line;
+
+        // Columns (the layout is fixed; unselected fields are stored empty)
+        types.push_back(static_cast<uint8_t>(token.type));
+        lexemes.push_back(intern((fields & ExportField::LEXEME) ? token.lexeme : EMPTY_STRING));
+
+        uint16_t code = BinaryTokenFormat::ATTR_NONE;
+        if (fields & ExportField::ATTRIBUTES) {
+            code = BinaryTokenFormat::encodeAttribute(token.attribute.get());
+        }
+        if (code & BinaryTokenFormat::ATTR_HAS_SCOPE) {
+            auto identifier = static_cast<const IdentifierAttribute*>(token.attribute.get());
+            scopes.emplace_back(static_cast<uint32_t>(tokenCount), intern(identifier->scope));
+        }
+        attributes.push_back(code);
+
+        if (!(fields & ExportField::FILENAME)) {
+            if (fileRuns.empty()) {
+                fileRuns.emplace_back(0, intern(EMPTY_STRING));
+            }
+        } else if (fileRuns.empty() || token.location.filename != lastFilename) {
+            fileRuns.emplace_back(static_cast<uint32_t>(tokenCount), intern(token.location.filename));
+            lastFilename = token.location.filename;
+        }
+    }
+
+    void writeFooter() override {
+        uint64_t positionsOffset = HEADER_SIZE;
+        uint64_t positionsEnd = relativeOffset();
+
+        std::string section;
+
+        // Types
+        padTo8(sink, base);
+        uint64_t typesOffset = relativeOffset();
+        sink.write(reinterpret_cast<const char*>(types.data()), types.size());
+
+        // Attributes
+        padTo8(sink, base);
+        uint64_t attributesOffset = relativeOffset();
+        section.clear();
+        for (uint16_t code : attributes) {
+            appendU16(section, code);
+        }
+        sink.write(section);
+
+        // Lexeme ids
+        padTo8(sink, base);
+        uint64_t lexemesOffset = relativeOffset();
+        section.clear();
+        for (uint32_t id : lexemes) {
+            appendU32(section, id);
+        }
+        sink.write(section);
+
+        // File runs and identifier scopes
+        padTo8(sink, base);
+        uint64_t fileRunsOffset = relativeOffset();
+        section.clear();
+        for (const auto& run : fileRuns) {
+            appendU32(section, run.first);
+            appendU32(section, run.second);
+        }
+        uint64_t scopesOffset = fileRunsOffset + section.size();
+        for (const auto& scope : scopes) {
+            appendU32(section, scope.first);
+            appendU32(section, scope.second);
+        }
+        sink.write(section);
+
+        // String table
+        padTo8(sink, base);
+        uint64_t stringsOffset = relativeOffset();
+        section.clear();
+        appendU32(section, static_cast<uint32_t>(strings.size()));
+        uint32_t stringOffset = 0;
+        for (const auto* text : strings) {
+            appendU32(section, stringOffset);
+            stringOffset += static_cast<uint32_t>(text->size());
+        }
+        appendU32(section, stringOffset);
+        sink.write(section);
+        for (const auto* text : strings) {
+            sink.write(*text);
+        }
+
+        // Block index
+        padTo8(sink, base);
+        uint64_t blocksOffset = relativeOffset();
+        section.clear();
+        for (uint64_t block : blocks) {
+            appendU64(section, block);
+        }
+        sink.write(section);
+
+        // Footer
+        section.clear();
+        appendU64(section, tokenCount);
+        appendU64(section, positionsOffset);
+        appendU64(section, positionsEnd);
+        appendU64(section, typesOffset);
+        appendU64(section, attributesOffset);
+        appendU64(section, lexemesOffset);
+        appendU64(section, fileRunsOffset);
+        appendU64(section, fileRuns.size());
+        appendU64(section, scopesOffset);
+        appendU64(section, scopes.size());
+        appendU64(section, stringsOffset);
+        appendU64(section, blocksOffset);
+        appendU64(section, blocks.size());
+        appendU32(section, static_cast<uint32_t>(FOOTER_SIZE));
+        section.append(MAGIC, 4);
+        sink.write(section);
+    }
+};
+
+} // namespace
+
+// Attribute encoding
+uint16_t BinaryTokenFormat::encodeAttribute(const TokenAttribute* attribute) {
+    if (!attribute) {
+        return ATTR_NONE;
+    }
+
+    if (auto number = dynamic_cast<const NumberAttribute*>(attribute)) {
+        return ATTR_NUMBER | (static_cast<uint16_t>(number->base) << 4) |
+               (number->isFloat ? 0x40 : 0) | (number->isScientific ? 0x80 : 0);
+    }
+    if (auto string = dynamic_cast<const StringAttribute*>(attribute)) {
+        return ATTR_STRING | (string->isRaw ? 0x10 : 0) | (string->hasEscapeSequences ? 0x20 : 0);
+    }
+    if (auto comment = dynamic_cast<const CommentAttribute*>(attribute)) {
+        return ATTR_COMMENT | (static_cast<uint16_t>(comment->commentType) << 4);
+    }
+    if (auto identifier = dynamic_cast<const IdentifierAttribute*>(attribute)) {
+        return ATTR_IDENTIFIER | (identifier->isDeclared ? 0x10 : 0) |
+               (identifier->isDefinition ? 0x20 : 0) | (identifier->scope.empty() ? 0 : ATTR_HAS_SCOPE);
+    }
+    if (auto directive = dynamic_cast<const PreprocessorAttribute*>(attribute)) {
+        return ATTR_PREPROCESSOR | (static_cast<uint16_t>(directive->directiveType) << 4);
+    }
+    return ATTR_NONE;
+}
+
+std::shared_ptr<TokenAttribute> BinaryTokenFormat::decodeAttribute(uint16_t code, std::string_view scope) {
+    switch (code & ATTR_KIND_MASK) {
+        case ATTR_NUMBER:
+            return std::make_shared<NumberAttribute>(
+                static_cast<NumberAttribute::Base>((code >> 4) & 0x3), (code & 0x40) != 0, (code & 0x80) != 0);
+        case ATTR_STRING:
+            return std::make_shared<StringAttribute>((code & 0x10) != 0, (code & 0x20) != 0);
+        case ATTR_COMMENT:
+            return std::make_shared<CommentAttribute>(static_cast<CommentAttribute::Type>((code >> 4) & 0x3));
+        case ATTR_IDENTIFIER:
+            return std::make_shared<IdentifierAttribute>((code & 0x10) != 0, (code & 0x20) != 0, std::string(scope));
+        case ATTR_PREPROCESSOR:
+            return std::make_shared<PreprocessorAttribute>(
+                static_cast<PreprocessorAttribute::Type>((code >> 4) & 0xF));
+        default:
+            return nullptr;
+    }
+}
+
+// Binary Exporter implementation
+std::unique_ptr<TokenWriter> BinaryExporter::createWriter(OutputSink& sink) const {
+    return std::make_unique<BinaryTokenWriter>(sink, fields, blockSize);
+}
+
+// BinaryTokenReader implementation
+BinaryTokenReader::BinaryTokenReader() {
+    close();
+}
+
+bool BinaryTokenReader::fail(const std::string& message) {
+    error = message;
+    file.close();
+    tokenCount = 0;
+    return false;
+}
+
+void BinaryTokenReader::close() {
+    file.close();
+    tokenCount = 0;
+    blockSize = BinaryTokenFormat::DEFAULT_BLOCK_SIZE;
+    positions = positionsEnd = types = attributes = lexemes = nullptr;
+    fileRuns = scopes = stringOffsets = stringBytes = blocks = nullptr;
+    fileRunCount = scopeCount = stringTableSize = blockCount = 0;
+}
+
+bool BinaryTokenReader::open(const std::string& filename) {
+    close();
+    error.clear();
+
+    if (!file.open(filename)) {
+        return fail("Could not map file: " + filename);
+    }
+
+    const uint8_t* data = file.bytes();
+    size_t size = file.size();
+
+    if (size < HEADER_SIZE + FOOTER_SIZE || std::string_view(reinterpret_cast<const char*>(data), 4) != "LXTK") {
+        return fail("Not a binary token file: " + filename);
+    }
+    if (loadU16(data + 4) != BinaryTokenFormat::VERSION) {
+        return fail("Unsupported binary token format version");
+    }
+    blockSize = loadU32(data + 8);
+
+    const uint8_t* footer = data + size - FOOTER_SIZE;
+    if (loadU32(footer + FOOTER_FIELDS * 8) != FOOTER_SIZE ||
+        std::string_view(reinterpret_cast<const char*>(footer + FOOTER_FIELDS * 8 + 4), 4) != "LXTK") {
+        return fail("Corrupt binary token footer");
+    }
+
+    uint64_t fields[FOOTER_FIELDS];
+    for (size_t i = 0; i < FOOTER_FIELDS; ++i) {
+        fields[i] = loadU64(footer + i * 8);
+    }
+
+    uint64_t count = fields[0];
+    uint64_t limit = size - FOOTER_SIZE;
+    auto fits = [limit](uint64_t offset, uint64_t bytes) {
+        return offset <= limit && bytes <= limit - offset;
+    };
+
+    if (blockSize == 0 || fields[2] < fields[1] || !fits(fields[1], fields[2] - fields[1]) ||
+        !fits(fields[3], count) || !fits(fields[4], count * 2) || !fits(fields[5], count * 4) ||
+        !fits(fields[6], fields[7] * 8) || !fits(fields[8], fields[9] * 8) ||
+        !fits(fields[10], 4) || !fits(fields[11], fields[12] * 8)) {
+        return fail("Corrupt binary token section table");
+    }
+
+    uint64_t strings = loadU32(data + fields[10]);
+    if (!fits(fields[10] + 4, (strings + 1) * 4)) {
+        return fail("Corrupt binary token string table");
+    }
+    const uint8_t* offsets = data + fields[10] + 4;
+    if (!fits(fields[10] + 4 + (strings + 1) * 4, loadU32(offsets + strings * 4))) {
+        return fail("Corrupt binary token string table");
+    }
+
+    tokenCount = count;
+    positions = data + fields[1];
+    positionsEnd = data + fields[2];
+    types = data + fields[3];
+    attributes = data + fields[4];
+    lexemes = data + fields[5];
+    fileRuns = data + fields[6];
+    fileRunCount = fields[7];
+    scopes = data + fields[8];
+    scopeCount = fields[9];
+    stringTableSize = strings;
+    stringOffsets = offsets;
+    stringBytes = offsets + (strings + 1) * 4;
+    blocks = data + fields[11];
+    blockCount = fields[12];
+
+    if (blockCount < (tokenCount + blockSize - 1) / blockSize) {
+        return fail("Corrupt binary token block index");
+    }
+    // Iterators start decoding at these offsets
+    for (uint64_t i = 0; i < blockCount; ++i) {
+        uint64_t offset = loadU64(blocks + i * 8);
+        if (offset < fields[1] || offset >= fields[2]) {
+            return fail("Corrupt binary token block index");
+        }
+    }
+    return true;
+}
+
+std::string_view BinaryTokenReader::string(uint32_t id) const {
+    if (id >= stringTableSize) {
+        return {};
+    }
+    uint32_t begin = loadU32(stringOffsets + id * 4);
+    uint32_t end = loadU32(stringOffsets + (id + 1) * 4);
+    // open() checked only the last offset against the file
+    if (end < begin || end > loadU32(stringOffsets + stringTableSize * 4)) {
+        return {};
+    }
+    return std::string_view(reinterpret_cast<const char*>(stringBytes + begin), end - begin);
+}
+
+TokenType BinaryTokenReader::type(size_t index) const {
+    if (index >= size()) {
+        return TokenType::UNKNOWN;
+    }
+    return static_cast<TokenType>(types[index]);
+}
+
+std::string_view BinaryTokenReader::lexeme(size_t index) const {
+    if (index >= size()) {
+        return {};
+    }
+    return string(loadU32(lexemes + index * 4));
+}
+
+uint16_t BinaryTokenReader::attributeCode(size_t index) const {
+    if (index >= size()) {
+        return 0;
+    }
+    return loadU16(attributes + index * 2);
+}
+
+size_t BinaryTokenReader::fileRunIndex(size_t index) const {
+    // Last run starting at or before the token
+    size_t low = 0;
+    size_t high = static_cast<size_t>(fileRunCount);
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (loadU32(fileRuns + mid * 8) <= index) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low > 0 ? low - 1 : 0;
+}
+
+std::string_view BinaryTokenReader::filename(size_t index) const {
+    if (fileRunCount == 0) {
+        return {};
+    }
+    return string(loadU32(fileRuns + fileRunIndex(index) * 8 + 4));
+}
+
+std::string_view BinaryTokenReader::scope(size_t index) const {
+    if (!(attributeCode(index) & BinaryTokenFormat::ATTR_HAS_SCOPE)) {
+        return {};
+    }
+
+    size_t low = 0;
+    size_t high = static_cast<size_t>(scopeCount);
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        uint32_t token = loadU32(scopes + mid * 8);
+        if (token == index) {
+            return string(loadU32(scopes + mid * 8 + 4));
+        }
+        if (token < index) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return {};
+}
+
+std::shared_ptr<TokenAttribute> BinaryTokenReader::attribute(size_t index) const {
+    return BinaryTokenFormat::decodeAttribute(attributeCode(index), scope(index));
+}
+
+TokenRecord BinaryTokenReader::at(size_t index) const {
+    if (index >= size()) {
+        throw std::out_of_range("BinaryTokenReader::at: token " + std::to_string(index) + " of " +
+                                std::to_string(size()));
+    }
+    // Decode forward from the first token of the block
+    size_t blockStart = index - index % blockSize;
+    Iterator it(this, blockStart);
+    while (it.position() < index) {
+        ++it;
+    }
+    return *it;
+}
+
+Token BinaryTokenReader::toToken(size_t index) const {
+    TokenRecord record = at(index);
+    Token token(record.type, std::string(record.lexeme),
+                SourceLocation(record.line, record.column, std::string(record.filename), record.offset));
+    token.attribute = attribute(index);
+    return token;
+}
+
+// Iterator implementation
+BinaryTokenReader::Iterator::Iterator(const BinaryTokenReader* reader, size_t index)
+    : reader(reader), index(index), cursor(nullptr), runIndex(0), record() {
+    if (index < reader->size()) {
+        size_t block = index / reader->blockSize;
+        cursor = reader->file.bytes() + loadU64(reader->blocks + block * 8);
+        runIndex = reader->fileRunIndex(index);
+        record.offset = 0;
+        record.line = 0;
+        decode();
+    }
+}
+
+void BinaryTokenReader::Iterator::decode() {
+    if (index % reader->blockSize == 0) {
+        record.offset = 0;
+        record.line = 0;
+    }
+
+    uint64_t offsetDelta = 0;
+    uint64_t lineDelta = 0;
+    uint64_t column = 0;
+    if (!readVarint(cursor, reader->positionsEnd, offsetDelta) ||
+        !readVarint(cursor, reader->positionsEnd, lineDelta) ||
+        !readVarint(cursor, reader->positionsEnd, column)) {
+        // Truncated position stream; stop iterating
+        index = reader->size();
+        return;
+    }
+
+    while (runIndex + 1 < reader->fileRunCount && loadU32(reader->fileRuns + (runIndex + 1) * 8) <= index) {
+        ++runIndex;
+    }
+
+    record.offset += static_cast<size_t>(offsetDelta);
+    record.line += static_cast<int>(zigzagDecode(lineDelta));
+    record.column = static_cast<int>(column);
+    record.type = reader->type(index);
+    record.lexeme = reader->lexeme(index);
+    record.attribute = reader->attributeCode(index);
+    record.filename = reader->fileRunCount > 0 ? reader->string(loadU32(reader->fileRuns + runIndex * 8 + 4))
+                                               : std::string_view();
+}
+
+BinaryTokenReader::Iterator& BinaryTokenReader::Iterator::operator++() {
+    ++index;
+    if (index < reader->size()) {
+        decode();
+    }
+    return *this;
+}
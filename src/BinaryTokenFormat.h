@@ -0,0 +1,152 @@
+#ifndef BINARY_TOKEN_FORMAT_H
+#define BINARY_TOKEN_FORMAT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "Token.h"
+#include "ExportFormatter.h"
+#include "MappedFile.h"
+
+// Compact binary token format ("LXTK"). All integers are little-endian.
+//
+//   header      magic "LXTK", u16 version, u16 reserved, u32 block size
+//   positions   per token: varint offset delta, zigzag varint line delta,
+//               varint column; deltas restart at every block boundary
+//   types       u8 TokenType per token
+//   attributes  u16 attribute code per token (see BinaryTokenFormat)
+//   lexemes     u32 string id per token
+//   file runs   (u32 first token, u32 string id) for every filename change
+//   scopes      (u32 token, u32 string id) for identifiers with a scope
+//   strings     u32 count, u32 offsets[count + 1], string bytes
+//   blocks      u64 file offset of each block's first position record
+//   footer      section offsets and counts, u32 footer size, magic "LXTK"
+//
+// Fixed-width columns give O(1) access to types and lexemes; positions are
+// decoded from the nearest block start.
+namespace BinaryTokenFormat {
+    constexpr uint16_t VERSION = 1;
+    constexpr uint32_t DEFAULT_BLOCK_SIZE = 4096;
+
+    // Attribute codes: kind in the low 4 bits, kind-specific flags above
+    enum AttributeKind : uint16_t {
+        ATTR_NONE = 0,
+        ATTR_NUMBER = 1,
+        ATTR_STRING = 2,
+        ATTR_COMMENT = 3,
+        ATTR_IDENTIFIER = 4,
+        ATTR_PREPROCESSOR = 5
+    };
+    constexpr uint16_t ATTR_KIND_MASK = 0x000F;
+    constexpr uint16_t ATTR_HAS_SCOPE = 0x0100;
+
+    uint16_t encodeAttribute(const TokenAttribute* attribute);
+    std::shared_ptr<TokenAttribute> decodeAttribute(uint16_t code, std::string_view scope);
+}
+
+// Binary exporter
+class BinaryExporter : public TokenExporter {
+private:
+    uint32_t blockSize;
+public:
+    BinaryExporter(uint32_t blockSize = BinaryTokenFormat::DEFAULT_BLOCK_SIZE)
+        : blockSize(blockSize > 0 ? blockSize : BinaryTokenFormat::DEFAULT_BLOCK_SIZE) {}
+
+    std::unique_ptr<TokenWriter> createWriter(OutputSink& sink) const override;
+};
+
+// A decoded token that points into the mapped file
+struct TokenRecord {
+    TokenType type;
+    std::string_view lexeme;
+    std::string_view filename;
+    size_t offset;
+    int line;
+    int column;
+    uint16_t attribute;
+};
+
+// Zero-copy reader for the binary token format. The file is memory-mapped
+// and tokens are decoded on demand; lexemes are views into the mapping.
+class BinaryTokenReader {
+private:
+    MappedFile file;
+    std::string error;
+
+    uint64_t tokenCount;
+    uint32_t blockSize;
+    const uint8_t* positions;
+    const uint8_t* positionsEnd;
+    const uint8_t* types;
+    const uint8_t* attributes;
+    const uint8_t* lexemes;
+    const uint8_t* fileRuns;
+    uint64_t fileRunCount;
+    const uint8_t* scopes;
+    uint64_t scopeCount;
+    const uint8_t* stringOffsets;
+    const uint8_t* stringBytes;
+    uint64_t stringTableSize;
+    const uint8_t* blocks;
+    uint64_t blockCount;
+
+    bool fail(const std::string& message);
+    size_t fileRunIndex(size_t index) const;
+
+public:
+    // Sequential iterator; decodes positions incrementally
+    class Iterator {
+    private:
+        const BinaryTokenReader* reader;
+        size_t index;
+        const uint8_t* cursor;
+        size_t runIndex;
+        TokenRecord record;
+
+        void decode();
+
+    public:
+        Iterator(const BinaryTokenReader* reader, size_t index);
+
+        const TokenRecord& operator*() const { return record; }
+        const TokenRecord* operator->() const { return &record; }
+        Iterator& operator++();
+        bool operator==(const Iterator& other) const { return index == other.index; }
+        bool operator!=(const Iterator& other) const { return index != other.index; }
+        size_t position() const { return index; }
+    };
+
+    BinaryTokenReader();
+
+    // Map and validate a binary token file
+    bool open(const std::string& filename);
+    void close();
+    const std::string& getError() const { return error; }
+
+    size_t size() const { return static_cast<size_t>(tokenCount); }
+
+    // Column access (O(1) except filename, which is a binary search); an
+    // index past the end gives an empty value
+    TokenType type(size_t index) const;
+    std::string_view lexeme(size_t index) const;
+    std::string_view filename(size_t index) const;
+    uint16_t attributeCode(size_t index) const;
+    std::string_view scope(size_t index) const;
+    std::shared_ptr<TokenAttribute> attribute(size_t index) const;
+
+    // Random access; decodes positions from the start of the token's block.
+    // Throws std::out_of_range for an index past the end.
+    TokenRecord at(size_t index) const;
+    Token toToken(size_t index) const;
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, size()); }
+
+    // String table access
+    size_t stringCount() const { return static_cast<size_t>(stringTableSize); }
+    std::string_view string(uint32_t id) const;
+};
+
+#endif // BINARY_TOKEN_FORMAT_H
@@ -0,0 +1,320 @@
+#include "BloomIndex.h"
+#include "Varint.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <cstdio>
+
+namespace {
+
+const char MAGIC[4] = {'L', 'X', 'B', 'F'};
+const size_t HEADER_SIZE = 40;
+const size_t FILTER_ENTRY_SIZE = 24;
+const size_t FILE_ENTRY_SIZE = 40;
+
+// Double hashing: probe i is at (h + i * delta) mod bits
+struct Probes {
+    uint64_t h;
+    uint64_t delta;
+
+    explicit Probes(uint64_t hash) : h(hash), delta((hash >> 33) | (hash << 31) | 1) {}
+
+    uint32_t next(uint32_t bits) {
+        uint32_t bit = static_cast<uint32_t>(h % bits);
+        h += delta;
+        return bit;
+    }
+};
+
+} // namespace
+
+uint64_t hashBytes(const char* data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    // FNV-1a mixes the last bytes poorly; finish with a 64-bit avalanche
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// BloomFilter implementation
+BloomFilter::BloomFilter(size_t keys) : words(std::max<size_t>(1, (keys * BITS_PER_KEY + 63) / 64), 0) {}
+
+void BloomFilter::add(uint64_t hash) {
+    Probes probes(hash);
+    const uint32_t bits = bitCount();
+    for (unsigned i = 0; i < HASHES; ++i) {
+        uint32_t bit = probes.next(bits);
+        words[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+}
+
+bool BloomFilter::mayContain(uint64_t hash) const {
+    Probes probes(hash);
+    const uint32_t bits = bitCount();
+    for (unsigned i = 0; i < HASHES; ++i) {
+        uint32_t bit = probes.next(bits);
+        if ((words[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BloomFilter::test(const uint8_t* bytes, uint32_t bits, uint64_t hash) {
+    if (bits == 0) {
+        return true;
+    }
+    Probes probes(hash);
+    for (unsigned i = 0; i < HASHES; ++i) {
+        uint32_t bit = probes.next(bits);
+        if ((bytes[bit / 8] & (1u << (bit % 8))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+BloomFilter BloomFilter::build(std::vector<uint64_t> hashes) {
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+    BloomFilter filter(hashes.size());
+    for (uint64_t hash : hashes) {
+        filter.add(hash);
+    }
+    return filter;
+}
+
+std::string normalizeSidecarPath(const std::string& path) {
+    return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+// BloomIndexBuilder implementation
+void BloomIndexBuilder::add(const BloomFileEntry& file, const std::vector<uint64_t>& words) {
+    BloomFileEntry entry = file;
+    entry.path = normalizeSidecarPath(file.path);
+    auto inserted = filesByPath.emplace(entry.path, files.size());
+    if (inserted.second) {
+        files.push_back(entry);
+    } else {
+        files[inserted.first->second] = entry;
+    }
+    filters.emplace(entry.contentHash, words);
+}
+
+bool BloomIndexBuilder::write(const std::string& filename, std::string& error) const {
+    // Only filters still referenced by a file are written, by content hash
+    std::vector<uint64_t> hashes;
+    for (const auto& file : files) {
+        hashes.push_back(file.contentHash);
+    }
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+    std::string filterSection;
+    std::string bitSection;
+    for (uint64_t hash : hashes) {
+        const auto& words = filters.at(hash);
+        appendU64(filterSection, hash);
+        appendU64(filterSection, bitSection.size());
+        appendU32(filterSection, static_cast<uint32_t>(words.size() * 64));
+        appendU32(filterSection, 0);
+        for (uint64_t word : words) {
+            appendU64(bitSection, word);
+        }
+    }
+
+    std::string fileSection;
+    std::string stringSection;
+    for (const auto& file : files) {
+        auto filter = std::lower_bound(hashes.begin(), hashes.end(), file.contentHash) - hashes.begin();
+        appendU64(fileSection, file.size);
+        appendU64(fileSection, static_cast<uint64_t>(file.modified));
+        appendU64(fileSection, file.contentHash);
+        appendU32(fileSection, static_cast<uint32_t>(filter));
+        appendU32(fileSection, static_cast<uint32_t>(stringSection.size()));
+        appendU32(fileSection, static_cast<uint32_t>(file.path.size()));
+        appendU32(fileSection, 0);
+        stringSection += file.path;
+    }
+
+    const uint64_t filesOffset = HEADER_SIZE + filterSection.size();
+    const uint64_t bitsOffset = filesOffset + fileSection.size();
+    const uint64_t stringsOffset = bitsOffset + bitSection.size();
+
+    std::string header(MAGIC, 4);
+    appendU16(header, BloomFormat::VERSION);
+    appendU16(header, BloomFilter::HASHES);
+    appendU32(header, static_cast<uint32_t>(files.size()));
+    appendU32(header, static_cast<uint32_t>(hashes.size()));
+    appendU64(header, filesOffset);
+    appendU64(header, bitsOffset);
+    appendU64(header, stringsOffset);
+
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            error = "could not create " + temporary;
+            return false;
+        }
+        out << header << filterSection << fileSection << bitSection << stringSection;
+        if (!out.flush()) {
+            error = "could not write " + temporary;
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        error = "could not replace " + filename;
+        return false;
+    }
+    return true;
+}
+
+// BloomIndex implementation
+BloomIndex::BloomIndex() {
+    close();
+}
+
+bool BloomIndex::fail(const std::string& message) {
+    close();
+    error = message;
+    return false;
+}
+
+void BloomIndex::close() {
+    file.close();
+    error.clear();
+    fileTotal = 0;
+    filterTotal = 0;
+    filterTable = nullptr;
+    fileTable = nullptr;
+    bits = nullptr;
+    bitsSize = 0;
+    strings = nullptr;
+    stringsSize = 0;
+    fileIndex.clear();
+}
+
+bool BloomIndex::open(const std::string& filename) {
+    close();
+    if (!file.open(filename)) {
+        return fail("could not open " + filename);
+    }
+    const uint8_t* data = file.bytes();
+    const uint64_t size = file.size();
+    if (size < HEADER_SIZE || !std::equal(MAGIC, MAGIC + 4, reinterpret_cast<const char*>(data))) {
+        return fail(filename + " is not a Bloom filter sidecar");
+    }
+    if (loadU16(data + 4) != BloomFormat::VERSION || loadU16(data + 6) != BloomFilter::HASHES) {
+        return fail(filename + " was written by an incompatible version");
+    }
+
+    const uint32_t files = loadU32(data + 8);
+    const uint32_t filters = loadU32(data + 12);
+    const uint64_t filesOffset = loadU64(data + 16);
+    const uint64_t bitsOffset = loadU64(data + 24);
+    const uint64_t stringsOffset = loadU64(data + 32);
+    if (filesOffset != HEADER_SIZE + static_cast<uint64_t>(filters) * FILTER_ENTRY_SIZE ||
+        bitsOffset != filesOffset + static_cast<uint64_t>(files) * FILE_ENTRY_SIZE ||
+        stringsOffset < bitsOffset || stringsOffset > size) {
+        return fail(filename + " is truncated or corrupt");
+    }
+
+    fileTotal = files;
+    filterTotal = filters;
+    filterTable = data + HEADER_SIZE;
+    fileTable = data + filesOffset;
+    bits = data + bitsOffset;
+    bitsSize = stringsOffset - bitsOffset;
+    strings = data + stringsOffset;
+    stringsSize = size - stringsOffset;
+    return true;
+}
+
+std::string_view BloomIndex::string(uint32_t offset, uint32_t length) const {
+    if (static_cast<uint64_t>(offset) + length > stringsSize) {
+        return std::string_view();
+    }
+    return std::string_view(reinterpret_cast<const char*>(strings + offset), length);
+}
+
+BloomFileEntry BloomIndex::getFile(size_t index) const {
+    const uint8_t* entry = fileTable + index * FILE_ENTRY_SIZE;
+    BloomFileEntry result;
+    result.size = loadU64(entry);
+    result.modified = static_cast<int64_t>(loadU64(entry + 8));
+    result.contentHash = loadU64(entry + 16);
+    result.path = std::string(string(loadU32(entry + 28), loadU32(entry + 32)));
+    return result;
+}
+
+std::vector<uint64_t> BloomIndex::getFilterWords(size_t fileIndex) const {
+    std::vector<uint64_t> words;
+    const uint32_t filter = loadU32(fileTable + fileIndex * FILE_ENTRY_SIZE + 24);
+    if (filter >= filterTotal) {
+        return words;
+    }
+    const uint8_t* entry = filterTable + filter * FILTER_ENTRY_SIZE;
+    const uint64_t offset = loadU64(entry + 8);
+    const uint32_t bitCount = loadU32(entry + 16);
+    if (offset + bitCount / 8 > bitsSize) {
+        return words;
+    }
+    for (uint32_t i = 0; i < bitCount / 64; ++i) {
+        words.push_back(loadU64(bits + offset + i * 8));
+    }
+    return words;
+}
+
+size_t BloomIndex::findFile(const std::string& path) const {
+    if (fileIndex.empty() && fileTotal > 0) {
+        fileIndex.reserve(fileTotal);
+        for (size_t i = 0; i < fileTotal; ++i) {
+            const uint8_t* entry = fileTable + i * FILE_ENTRY_SIZE;
+            fileIndex.emplace(string(loadU32(entry + 28), loadU32(entry + 32)), i);
+        }
+    }
+    auto it = fileIndex.find(normalizeSidecarPath(path));
+    return it == fileIndex.end() ? NONE : it->second;
+}
+
+bool BloomIndex::mayContainAll(size_t fileIndex, const std::vector<uint64_t>& hashes) const {
+    const uint32_t filter = loadU32(fileTable + fileIndex * FILE_ENTRY_SIZE + 24);
+    if (filter >= filterTotal) {
+        return true;
+    }
+    const uint8_t* entry = filterTable + filter * FILTER_ENTRY_SIZE;
+    const uint64_t offset = loadU64(entry + 8);
+    const uint32_t bitCount = loadU32(entry + 16);
+    if (offset + bitCount / 8 > bitsSize) {
+        return true;
+    }
+    for (uint64_t hash : hashes) {
+        if (!BloomFilter::test(bits + offset, bitCount, hash)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<size_t> BloomIndex::candidates(const std::vector<std::string>& names) const {
+    std::vector<uint64_t> hashes;
+    for (const auto& name : names) {
+        hashes.push_back(hashBytes(name));
+    }
+    std::vector<size_t> result;
+    for (size_t i = 0; i < fileTotal; ++i) {
+        if (mayContainAll(i, hashes)) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,137 @@
+#ifndef BLOOM_INDEX_H
+#define BLOOM_INDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "MappedFile.h"
+
+// Stable 64-bit hash of a byte string (FNV-1a with a final mix). Used for
+// identifiers and whole file contents, and stored on disk, so it must not
+// change between builds the way std::hash may.
+uint64_t hashBytes(const char* data, size_t size);
+inline uint64_t hashBytes(std::string_view text) { return hashBytes(text.data(), text.size()); }
+
+// Bloom filter over a file's identifier lexemes: about 10 bits and 7 probes
+// per distinct identifier, for roughly a 1% false positive rate. Probes are
+// derived from one 64-bit hash by double hashing.
+class BloomFilter {
+private:
+    std::vector<uint64_t> words;
+
+public:
+    static constexpr unsigned HASHES = 7;
+    static constexpr unsigned BITS_PER_KEY = 10;
+
+    // Sized for keys distinct hashes (at least 64 bits)
+    explicit BloomFilter(size_t keys = 0);
+
+    void add(uint64_t hash);
+    bool mayContain(uint64_t hash) const;
+
+    uint32_t bitCount() const { return static_cast<uint32_t>(words.size() * 64); }
+    const std::vector<uint64_t>& getWords() const { return words; }
+
+    // Probe a filter stored on disk as little-endian 64-bit words
+    static bool test(const uint8_t* bytes, uint32_t bits, uint64_t hash);
+
+    // Filter over the distinct hashes given
+    static BloomFilter build(std::vector<uint64_t> hashes);
+};
+
+// A file recorded in the sidecar, with the size, modification time and
+// content hash its filter was built from
+struct BloomFileEntry {
+    std::string path;
+    uint64_t size;
+    int64_t modified;
+    uint64_t contentHash;
+};
+
+// Sidecar index of per-file Bloom filters ("LXBF"). All integers are
+// little-endian.
+//
+//   header   magic "LXBF", u16 version, u16 probes, u32 file count,
+//            u32 filter count, u64 files offset, u64 bits offset,
+//            u64 strings offset
+//   filters  per filter, sorted by content hash: u64 content hash,
+//            u64 bits offset (relative), u32 bit count, u32 reserved
+//   files    per file: u64 size, i64 modification time, u64 content hash,
+//            u32 filter, u32 path offset, u32 path length, u32 reserved
+//   bits     filter words
+//   strings  file paths
+//
+// Filters are keyed by content hash, so files with identical contents share
+// one and a file that is renamed or reverted keeps its filter.
+namespace BloomFormat {
+    constexpr uint16_t VERSION = 1;
+}
+
+// Collects filters and writes the sidecar
+class BloomIndexBuilder {
+private:
+    std::vector<BloomFileEntry> files;
+    std::unordered_map<std::string, size_t> filesByPath;
+    std::unordered_map<uint64_t, std::vector<uint64_t>> filters; // content hash -> words
+
+public:
+    // Record a file; a later entry for the same path replaces it
+    void add(const BloomFileEntry& file, const std::vector<uint64_t>& words);
+
+    bool hasFile(const std::string& path) const { return filesByPath.count(path) > 0; }
+    size_t fileCount() const { return files.size(); }
+
+    // Write to a temporary file and rename it over filename
+    bool write(const std::string& filename, std::string& error) const;
+};
+
+// Read-only view of a sidecar; the file is memory-mapped
+class BloomIndex {
+private:
+    MappedFile file;
+    std::string error;
+
+    uint32_t fileTotal;
+    uint32_t filterTotal;
+    const uint8_t* filterTable;
+    const uint8_t* fileTable;
+    const uint8_t* bits;
+    uint64_t bitsSize;
+    const uint8_t* strings;
+    uint64_t stringsSize;
+    mutable std::unordered_map<std::string_view, size_t> fileIndex;
+
+    bool fail(const std::string& message);
+    std::string_view string(uint32_t offset, uint32_t length) const;
+
+public:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    BloomIndex();
+
+    bool open(const std::string& filename);
+    void close();
+    const std::string& getError() const { return error; }
+
+    size_t fileCount() const { return fileTotal; }
+    size_t filterCount() const { return filterTotal; }
+    BloomFileEntry getFile(size_t index) const;
+    std::vector<uint64_t> getFilterWords(size_t fileIndex) const;
+
+    // Index of a recorded path (compared after lexical normalization), or NONE
+    size_t findFile(const std::string& path) const;
+
+    // False if at least one of the identifier hashes certainly does not
+    // occur in the file; true if they may all occur
+    bool mayContainAll(size_t fileIndex, const std::vector<uint64_t>& hashes) const;
+
+    // Files whose identifiers may include every one of names, in recorded order
+    std::vector<size_t> candidates(const std::vector<std::string>& names) const;
+};
+
+// Lexically normalized form of a path, as stored in the sidecar
+std::string normalizeSidecarPath(const std::string& path);
+
+#endif // BLOOM_INDEX_H
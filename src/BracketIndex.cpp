@@ -0,0 +1,105 @@
+#include "BracketIndex.h"
+
+namespace {
+
+// Opening bracket for a closer, or 0 if the lexeme is not a closer
+char openerFor(char closer) {
+    switch (closer) {
+        case ')': return '(';
+        case ']': return '[';
+        case '}': return '{';
+        default: return 0;
+    }
+}
+
+} // namespace
+
+BracketIndex::BracketIndex() : pairCount(0), maxDepth(0), finished(false) {}
+
+bool BracketIndex::isBracket(const Token& token) {
+    // Brackets are delimiters, but some plugins classify them as operators;
+    // literals and comments that happen to be one bracket long never count
+    if (token.lexeme.size() != 1 || token.type < TokenType::OPERATOR || token.type > TokenType::DOT) {
+        return false;
+    }
+    char symbol = token.lexeme[0];
+    return symbol == '(' || symbol == ')' || symbol == '[' || symbol == ']' || symbol == '{' || symbol == '}';
+}
+
+void BracketIndex::clear() {
+    partners.clear();
+    depths.clear();
+    open.clear();
+    diagnostics.clear();
+    pairCount = 0;
+    maxDepth = 0;
+    finished = false;
+}
+
+void BracketIndex::reportUnclosed(const OpenBracket& bracket) {
+    diagnostics.push_back({std::string("unclosed '") + bracket.symbol + "'", bracket.location, bracket.token});
+}
+
+void BracketIndex::add(const Token& token) {
+    const uint32_t index = static_cast<uint32_t>(depths.size());
+    partners.push_back(NONE);
+    depths.push_back(static_cast<uint32_t>(open.size()));
+
+    if (token.type == TokenType::EOF_TOKEN) {
+        finish();
+        return;
+    }
+    if (!isBracket(token)) {
+        return;
+    }
+
+    const char symbol = token.lexeme[0];
+    if (symbol == '(' || symbol == '[' || symbol == '{') {
+        open.push_back({index, symbol, token.location});
+        if (open.size() > maxDepth) {
+            maxDepth = static_cast<uint32_t>(open.size());
+        }
+        return;
+    }
+    const char opener = openerFor(symbol);
+
+    // Find the nearest open bracket this closes
+    size_t match = open.size();
+    while (match > 0 && open[match - 1].symbol != opener) {
+        --match;
+    }
+    if (match == 0) {
+        diagnostics.push_back({std::string("unmatched '") + symbol + "'", token.location, index});
+        return;
+    }
+
+    for (size_t i = open.size(); i > match; --i) {
+        reportUnclosed(open[i - 1]);
+    }
+    const uint32_t partner = open[match - 1].token;
+    open.resize(match - 1);
+
+    partners[index] = partner;
+    partners[partner] = index;
+    depths[index] = depths[partner];
+    ++pairCount;
+}
+
+void BracketIndex::finish() {
+    if (finished) {
+        return;
+    }
+    for (size_t i = open.size(); i > 0; --i) {
+        reportUnclosed(open[i - 1]);
+    }
+    open.clear();
+    finished = true;
+}
+
+std::string BracketIndex::report() const {
+    std::string result;
+    for (const auto& diagnostic : diagnostics) {
+        result += diagnostic.location.toString() + ": " + diagnostic.message + "\n";
+    }
+    return result;
+}
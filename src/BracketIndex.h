@@ -0,0 +1,76 @@
+#ifndef BRACKET_INDEX_H
+#define BRACKET_INDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Token.h"
+
+// An unmatched or mismatched delimiter
+struct BracketDiagnostic {
+    std::string message;
+    SourceLocation location;
+    size_t token; // index of the offending token
+};
+
+// Matching ( ) [ ] { } pairs, built as tokens are produced. Any operator
+// or delimiter token consisting of one bracket character counts. Every token
+// gets a nesting depth (the number of brackets open around it; a pair's
+// two tokens share the depth outside them) and each matched bracket the
+// index of its partner, so parsers can jump over a body in O(1).
+//
+// A closer that does not match the innermost open bracket is paired with
+// the nearest matching one further out if there is one, and the brackets
+// in between are reported as unclosed; otherwise it is reported as stray.
+class BracketIndex {
+private:
+    struct OpenBracket {
+        uint32_t token;
+        char symbol;
+        SourceLocation location;
+    };
+
+    std::vector<uint32_t> partners;
+    std::vector<uint32_t> depths;
+    std::vector<OpenBracket> open; // innermost last
+    std::vector<BracketDiagnostic> diagnostics;
+    size_t pairCount;
+    uint32_t maxDepth;
+    bool finished;
+
+    void reportUnclosed(const OpenBracket& bracket);
+
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    BracketIndex();
+
+    // True for an operator or delimiter token that is a single bracket
+    static bool isBracket(const Token& token);
+
+    void clear();
+
+    // Record the next token; EOF reports the brackets still open
+    void add(const Token& token);
+
+    // Report the brackets still open; called by add on EOF
+    void finish();
+
+    size_t size() const { return depths.size(); }
+
+    // Partner of the bracket at index, or NONE
+    uint32_t partner(size_t index) const { return index < partners.size() ? partners[index] : NONE; }
+
+    uint32_t depth(size_t index) const { return index < depths.size() ? depths[index] : 0; }
+
+    size_t pairs() const { return pairCount; }
+    uint32_t maximumDepth() const { return maxDepth; }
+
+    bool isBalanced() const { return diagnostics.empty() && open.empty(); }
+    const std::vector<BracketDiagnostic>& getDiagnostics() const { return diagnostics; }
+
+    // Diagnostics, one per line
+    std::string report() const;
+};
+
+#endif // BRACKET_INDEX_H
@@ -0,0 +1,253 @@
+#include "ByteScan.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LEX_HAVE_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// ByteSet implementation
+ByteSet::ByteSet() : bytes{}, count(0), below(0), vectorizable(true), table{} {}
+
+ByteSet::ByteSet(std::string_view members, unsigned char below)
+    : bytes{}, count(0), below(below), vectorizable(below <= 0x80), table{} {
+    for (int c = 0; c < below; ++c) {
+        table[c] = true;
+    }
+    for (char c : members) {
+        add(static_cast<unsigned char>(c));
+    }
+}
+
+void ByteSet::add(unsigned char c) {
+    if (table[c]) {
+        return;
+    }
+    table[c] = true;
+
+    if (count < MAX_VECTOR_BYTES) {
+        bytes[count++] = c;
+    } else {
+        vectorizable = false;
+    }
+}
+
+namespace {
+
+size_t findFirstOfScalar(const char* data, size_t begin, size_t size, const ByteSet& set) {
+    for (size_t i = begin; i < size; ++i) {
+        if (set.contains(static_cast<unsigned char>(data[i]))) {
+            return i;
+        }
+    }
+    return size;
+}
+
+#if defined(__AVX2__)
+
+size_t findFirstOfVector(const char* data, size_t size, const ByteSet& set) {
+    __m256i needles[ByteSet::MAX_VECTOR_BYTES];
+    for (size_t k = 0; k < set.size(); ++k) {
+        needles[k] = _mm256_set1_epi8(static_cast<char>(set.byteAt(k)));
+    }
+    const bool checkBelow = set.getBelow() > 0;
+    const __m256i limit = _mm256_set1_epi8(static_cast<char>(set.getBelow() - 1));
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i hits = _mm256_setzero_si256();
+        for (size_t k = 0; k < set.size(); ++k) {
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, needles[k]));
+        }
+        if (checkBelow) {
+            // Unsigned x <= limit  <=>  min(x, limit) == x
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, limit), chunk));
+        }
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return findFirstOfScalar(data, i, size, set);
+}
+
+#elif defined(LEX_HAVE_SSE2)
+
+size_t findFirstOfVector(const char* data, size_t size, const ByteSet& set) {
+    __m128i needles[ByteSet::MAX_VECTOR_BYTES];
+    for (size_t k = 0; k < set.size(); ++k) {
+        needles[k] = _mm_set1_epi8(static_cast<char>(set.byteAt(k)));
+    }
+    const bool checkBelow = set.getBelow() > 0;
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(set.getBelow() - 1));
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hits = _mm_setzero_si128();
+        for (size_t k = 0; k < set.size(); ++k) {
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, needles[k]));
+        }
+        if (checkBelow) {
+            // Unsigned x <= limit  <=>  min(x, limit) == x
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_min_epu8(chunk, limit), chunk));
+        }
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return i + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+    return findFirstOfScalar(data, i, size, set);
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+size_t findFirstOfVector(const char* data, size_t size, const ByteSet& set) {
+    uint8x16_t needles[ByteSet::MAX_VECTOR_BYTES];
+    for (size_t k = 0; k < set.size(); ++k) {
+        needles[k] = vdupq_n_u8(set.byteAt(k));
+    }
+    const bool checkBelow = set.getBelow() > 0;
+    const uint8x16_t limit = vdupq_n_u8(set.getBelow());
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+        uint8x16_t hits = vdupq_n_u8(0);
+        for (size_t k = 0; k < set.size(); ++k) {
+            hits = vorrq_u8(hits, vceqq_u8(chunk, needles[k]));
+        }
+        if (checkBelow) {
+            hits = vorrq_u8(hits, vcltq_u8(chunk, limit));
+        }
+        if (vmaxvq_u8(hits) != 0) {
+            return findFirstOfScalar(data, i, i + 16, set);
+        }
+    }
+    return findFirstOfScalar(data, i, size, set);
+}
+
+#else
+
+// Portable SWAR fallback (also used for WebAssembly): test 8 bytes per step
+size_t findFirstOfVector(const char* data, size_t size, const ByteSet& set) {
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t highs = 0x8080808080808080ULL;
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+
+        uint64_t hits = 0;
+        for (size_t k = 0; k < set.size(); ++k) {
+            uint64_t x = word ^ (ones * set.byteAt(k));
+            hits |= (x - ones) & ~x & highs;
+        }
+        if (set.getBelow() > 0) {
+            hits |= (word - ones * set.getBelow()) & ~word & highs;
+        }
+        if (hits != 0) {
+            // Borrows can flag bytes after a real match, never before it
+            return findFirstOfScalar(data, i, size, set);
+        }
+    }
+    return findFirstOfScalar(data, i, size, set);
+}
+
+#endif
+
+} // namespace
+
+size_t findFirstOf(const char* data, size_t size, const ByteSet& set) {
+    if (!set.isVectorizable()) {
+        return findFirstOfScalar(data, 0, size, set);
+    }
+    return findFirstOfVector(data, size, set);
+}
+
+size_t countByte(const char* data, size_t size, char c) {
+    size_t total = 0;
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i needle = _mm256_set1_epi8(c);
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+        total += static_cast<size_t>(__builtin_popcount(mask));
+    }
+#elif defined(LEX_HAVE_SSE2)
+    const __m128i needle = _mm_set1_epi8(c);
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        total += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(mask)));
+    }
+#endif
+
+    return total + static_cast<size_t>(std::count(data + i, data + size, c));
+}
+
+size_t findSubstring(const char* data, size_t size, std::string_view needle) {
+    const size_t length = needle.size();
+    if (length == 0) {
+        return 0;
+    }
+    if (length > size) {
+        return size;
+    }
+    if (length == 1) {
+        const void* hit = std::memchr(data, needle[0], size);
+        return hit ? static_cast<size_t>(static_cast<const char*>(hit) - data) : size;
+    }
+
+    // Last index at which the needle can start
+    const size_t lastStart = size - length;
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[length - 1]);
+    for (; i + 32 <= lastStart + 1; i += 32) {
+        __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + length - 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last))));
+        while (mask != 0) {
+            size_t candidate = i + __builtin_ctz(mask);
+            if (std::memcmp(data + candidate + 1, needle.data() + 1, length - 2) == 0) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+#elif defined(LEX_HAVE_SSE2)
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[length - 1]);
+    for (; i + 16 <= lastStart + 1; i += 16) {
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + length - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last))));
+        while (mask != 0) {
+            size_t candidate = i + __builtin_ctz(mask);
+            if (std::memcmp(data + candidate + 1, needle.data() + 1, length - 2) == 0) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    std::string_view rest(data + i, size - i);
+    size_t hit = rest.find(needle);
+    return hit == std::string_view::npos ? size : i + hit;
+}
@@ -0,0 +1,48 @@
+#ifndef BYTE_SCAN_H
+#define BYTE_SCAN_H
+
+#include <string_view>
+#include <cstddef>
+
+// A set of byte values to search for. Up to MAX_VECTOR_BYTES explicit bytes
+// (plus an optional "every byte below N" range for control characters) are
+// matched 16-32 bytes at a time with SIMD compares; larger sets fall back
+// to a per-byte table lookup.
+class ByteSet {
+public:
+    static constexpr size_t MAX_VECTOR_BYTES = 8;
+
+private:
+    unsigned char bytes[MAX_VECTOR_BYTES];
+    size_t count;
+    unsigned char below;
+    bool vectorizable;
+    bool table[256];
+
+public:
+    ByteSet();
+    explicit ByteSet(std::string_view members, unsigned char below = 0);
+
+    void add(unsigned char c);
+
+    bool contains(unsigned char c) const { return table[c]; }
+
+    bool isVectorizable() const { return vectorizable; }
+    size_t size() const { return count; }
+    unsigned char byteAt(size_t index) const { return bytes[index]; }
+    unsigned char getBelow() const { return below; }
+};
+
+// Index of the first byte in [data, data + size) that is in the set, or
+// size if there is none
+size_t findFirstOf(const char* data, size_t size, const ByteSet& set);
+
+// Number of occurrences of a byte (e.g. newlines) in a range
+size_t countByte(const char* data, size_t size, char c);
+
+// Index of the first occurrence of needle in [data, data + size), or size.
+// Candidates are found by comparing the needle's first and last bytes
+// 16-32 positions at a time and only then checked in full.
+size_t findSubstring(const char* data, size_t size, std::string_view needle);
+
+#endif // BYTE_SCAN_H
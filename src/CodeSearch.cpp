@@ -0,0 +1,125 @@
+#include "CodeSearch.h"
+#include "ByteScan.h"
+#include "Lexer.h"
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+namespace {
+
+// A token seen in the current lexed region
+struct RegionToken {
+    TokenType type;
+    size_t begin;
+    size_t end;
+    bool exact;
+};
+
+} // namespace
+
+CodeSearch::CodeSearch(const std::string& pattern) : pattern(pattern), typed(false), wholeToken(false) {}
+
+void CodeSearch::setTypes(const std::vector<TokenType>& tokenTypes) {
+    types = TokenFilter();
+    typed = !tokenTypes.empty();
+    if (typed) {
+        types.keepOnly(tokenTypes);
+    }
+}
+
+std::vector<SearchHit> CodeSearch::search(std::string_view source, const LanguageConfig& config,
+                                          const Extractor& spans, const std::string& filename) const {
+    std::vector<SearchHit> hits;
+    if (pattern.empty()) {
+        return hits;
+    }
+
+    // Prefilter: candidate offsets from the raw bytes
+    std::vector<size_t> candidates;
+    for (size_t from = 0; from < source.size();) {
+        size_t hit = from + findSubstring(source.data() + from, source.size() - from, pattern);
+        if (hit >= source.size()) {
+            break;
+        }
+        candidates.push_back(hit);
+        from = hit + 1;
+    }
+    if (candidates.empty()) {
+        return hits;
+    }
+
+    // Comments, strings and directives up to the last candidate; a line
+    // start inside one of them is not a token boundary
+    std::vector<std::pair<size_t, size_t>> blocks;
+    std::unique_ptr<Lexer> lexer;
+    if (needsLexing()) {
+        size_t last = candidates.back();
+        spans.forEachSpan(source, [&blocks, last](size_t begin, size_t end) {
+            if (begin > last) {
+                return false;
+            }
+            blocks.emplace_back(begin, end);
+            return true;
+        });
+
+        lexer = std::make_unique<Lexer>(std::string(source), config, filename);
+        lexer->setSymbolTable(nullptr);
+    }
+
+    std::vector<RegionToken> region;
+    size_t regionEnd = 0;
+    size_t counted = 0;
+    int line = 1;
+
+    for (size_t candidate : candidates) {
+        size_t lineStart = candidate == 0 ? 0 : source.rfind('\n', candidate - 1);
+        lineStart = lineStart == std::string_view::npos || candidate == 0 ? 0 : lineStart + 1;
+
+        TokenType type = TokenType::UNKNOWN;
+        if (lexer) {
+            if (region.empty() || candidate >= regionEnd) {
+                size_t restart = lineStart;
+                auto block = std::upper_bound(blocks.begin(), blocks.end(),
+                                              std::make_pair(restart, static_cast<size_t>(-1)));
+                if (block != blocks.begin() && restart < std::prev(block)->second) {
+                    restart = std::prev(block)->first;
+                }
+
+                // Keep lexing from where the last region stopped if possible
+                if (region.empty() || restart > regionEnd) {
+                    region.clear();
+                } else {
+                    restart = regionEnd;
+                }
+                lexer->tokenizeRange(restart, candidate + 1, [&](const Token& token, size_t end) {
+                    region.push_back({token.type, token.location.offset, end, token.lexeme == pattern});
+                });
+                regionEnd = region.empty() ? 0 : region.back().end;
+            }
+
+            // Token containing the start of the match
+            auto token = std::upper_bound(region.begin(), region.end(), candidate,
+                                          [](size_t offset, const RegionToken& t) { return offset < t.begin; });
+            if (token == region.begin() || candidate >= std::prev(token)->end) {
+                continue;
+            }
+            const RegionToken& found = *std::prev(token);
+            if ((typed && types.drops(found.type)) || (wholeToken && !found.exact)) {
+                continue;
+            }
+            type = found.type;
+        }
+
+        line += static_cast<int>(countByte(source.data() + counted, lineStart - counted, '\n'));
+        counted = lineStart;
+
+        size_t lineEnd = source.find('\n', candidate);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = source.size();
+        }
+        hits.push_back({line, static_cast<int>(candidate - lineStart + 1), candidate, type,
+                        std::string(source.substr(lineStart, lineEnd - lineStart))});
+    }
+
+    return hits;
+}
@@ -0,0 +1,52 @@
+#ifndef CODE_SEARCH_H
+#define CODE_SEARCH_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Token.h"
+#include "TokenFilter.h"
+#include "LanguageConfig.h"
+#include "Extractor.h"
+
+// One occurrence found by a code search
+struct SearchHit {
+    int line;
+    int column;
+    size_t offset;
+    TokenType type;       // type of the token containing the match
+    std::string lineText; // the whole source line, without the newline
+};
+
+// Token-aware substring search. The raw bytes are searched first with
+// findSubstring, so sources without the pattern are never lexed. Around
+// each candidate the lexer is restarted at a safe point (the start of the
+// line, or of the comment, string or directive covering it, as found by
+// the Extractor) and run only until the token containing the match is
+// known; that token's type decides whether the match counts.
+class CodeSearch {
+private:
+    std::string pattern;
+    TokenFilter types;
+    bool typed;
+    bool wholeToken;
+
+public:
+    explicit CodeSearch(const std::string& pattern);
+
+    // Only accept matches inside tokens of these types
+    void setTypes(const std::vector<TokenType>& tokenTypes);
+
+    // Only accept tokens whose lexeme is exactly the pattern
+    void setWholeToken(bool whole) { wholeToken = whole; }
+
+    const std::string& getPattern() const { return pattern; }
+
+    // True if matches have to be confirmed by lexing
+    bool needsLexing() const { return typed || wholeToken; }
+
+    std::vector<SearchHit> search(std::string_view source, const LanguageConfig& config,
+                                  const Extractor& spans, const std::string& filename = "") const;
+};
+
+#endif // CODE_SEARCH_H
@@ -0,0 +1,211 @@
+#include "DatasetWriter.h"
+#include "Escape.h"
+#include "Varint.h"
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+// .npy headers are padded to a fixed size so a column can be streamed
+// before its length is known and the header patched in at the end
+constexpr size_t NPY_HEADER_SIZE = 128;
+
+std::string npyHeader(const char* descr, size_t count) {
+    std::string header("\x93NUMPY\x01\x00", 8);
+    appendU16(header, static_cast<uint16_t>(NPY_HEADER_SIZE - 10));
+    header += "{'descr': '";
+    header += descr;
+    header += "', 'fortran_order': False, 'shape': (" + std::to_string(count) + ",), }";
+    header.append(NPY_HEADER_SIZE - 1 - header.size(), ' ');
+    header.push_back('\n');
+    return header;
+}
+
+void writeInt32s(OutputSink& sink, const std::vector<int32_t>& values) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    sink.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(int32_t));
+#else
+    std::string bytes;
+    bytes.reserve(values.size() * sizeof(int32_t));
+    for (int32_t value : values) {
+        appendU32(bytes, static_cast<uint32_t>(value));
+    }
+    sink.write(bytes);
+#endif
+}
+
+} // namespace
+
+// LexemeVocabulary implementation
+uint32_t LexemeVocabulary::intern(const std::string& lexeme, uint64_t count) {
+    auto result = ids.emplace(lexeme, static_cast<uint32_t>(lexemes.size()));
+    if (result.second) {
+        lexemes.push_back(&result.first->first);
+        counts.push_back(0);
+    }
+    uint32_t id = result.first->second;
+    counts[id] += count;
+    return id;
+}
+
+// DatasetDocument implementation
+void DatasetDocument::add(const Token& token) {
+    ids.push_back(static_cast<int32_t>(vocabulary.intern(token.lexeme)));
+    types.push_back(static_cast<int32_t>(token.type));
+    lines.push_back(token.location.line);
+    columns.push_back(token.location.column);
+}
+
+// DatasetWriter implementation
+bool DatasetWriter::parseFormat(const std::string& name, Format& format) {
+    if (name == "npy") {
+        format = Format::NPY;
+    } else if (name == "raw") {
+        format = Format::RAW;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+DatasetWriter::DatasetWriter(const std::string& directory, Format format)
+    : directory(directory), format(format), offsets{0}, tokenCount(0) {}
+
+std::string DatasetWriter::path(const std::string& name) const {
+    return (std::filesystem::path(directory) / name).string();
+}
+
+bool DatasetWriter::openColumn(Column& column, const std::string& name) {
+    column.name = name + (format == Format::NPY ? ".npy" : ".i32");
+    column.sink = std::make_unique<FileSink>(path(column.name));
+    if (!column.sink->isOpen()) {
+        return false;
+    }
+    if (format == Format::NPY) {
+        column.sink->write(std::string(NPY_HEADER_SIZE, ' '));
+    }
+    return true;
+}
+
+bool DatasetWriter::open() {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        return false;
+    }
+    return openColumn(ids, "tokens") && openColumn(types, "types") &&
+           openColumn(lines, "lines") && openColumn(columns, "columns");
+}
+
+void DatasetWriter::appendColumn(Column& column, const std::vector<int32_t>& values) {
+    writeInt32s(*column.sink, values);
+    column.count += values.size();
+}
+
+void DatasetWriter::addDocument(DatasetDocument& document) {
+    // Local ids are in first-occurrence order, so interning them in order
+    // gives the same global ids as lexing every file on one thread
+    std::vector<int32_t> remap(document.vocabulary.size());
+    for (uint32_t id = 0; id < remap.size(); ++id) {
+        remap[id] = static_cast<int32_t>(
+            vocabulary.intern(document.vocabulary.lexeme(id), document.vocabulary.count(id)));
+    }
+    for (auto& id : document.ids) {
+        id = remap[id];
+    }
+
+    appendColumn(ids, document.ids);
+    appendColumn(types, document.types);
+    appendColumn(lines, document.lines);
+    appendColumn(columns, document.columns);
+
+    tokenCount += document.size();
+    offsets.push_back(static_cast<int64_t>(tokenCount));
+    files.emplace_back(document.filename, document.size());
+}
+
+bool DatasetWriter::finishColumn(Column& column, const char* descr) {
+    if (!column.sink) {
+        return false;
+    }
+    bool success = column.sink->flush();
+    if (format == Format::NPY) {
+        std::string header = npyHeader(descr, column.count);
+        success = column.sink->writeAt(header.data(), header.size(), 0) && success;
+    }
+    return column.sink->close() && success;
+}
+
+bool DatasetWriter::writeOffsets() {
+    FileSink sink(path(format == Format::NPY ? "offsets.npy" : "offsets.i64"));
+    if (!sink.isOpen()) {
+        return false;
+    }
+    if (format == Format::NPY) {
+        sink.write(npyHeader("<i8", offsets.size()));
+    }
+    std::string bytes;
+    bytes.reserve(offsets.size() * sizeof(int64_t));
+    for (int64_t offset : offsets) {
+        appendU64(bytes, static_cast<uint64_t>(offset));
+    }
+    sink.write(bytes);
+    return sink.close();
+}
+
+bool DatasetWriter::writeVocabulary() const {
+    FileSink sink(path("vocab.tsv"));
+    if (!sink.isOpen()) {
+        return false;
+    }
+    for (uint32_t id = 0; id < vocabulary.size(); ++id) {
+        sink.writeUInt(id);
+        sink.put('\t');
+        sink.writeUInt(vocabulary.count(id));
+        sink.put('\t');
+        Escape::write(sink, vocabulary.lexeme(id), Escape::Format::JSON);
+        sink.put('\n');
+    }
+    return sink.close();
+}
+
+bool DatasetWriter::writeTypes() const {
+    FileSink sink(path("types.tsv"));
+    if (!sink.isOpen()) {
+        return false;
+    }
+    for (int type = 0; type <= static_cast<int>(TokenType::UNKNOWN); ++type) {
+        sink.writeInt(type);
+        sink.put('\t');
+        sink.write(Token(static_cast<TokenType>(type), "", 0, 0).typeToString());
+        sink.put('\n');
+    }
+    return sink.close();
+}
+
+bool DatasetWriter::writeFiles() const {
+    FileSink sink(path("files.tsv"));
+    if (!sink.isOpen()) {
+        return false;
+    }
+    for (size_t i = 0; i < files.size(); ++i) {
+        sink.writeUInt(i);
+        sink.put('\t');
+        sink.writeUInt(files[i].second);
+        sink.put('\t');
+        sink.write(files[i].first);
+        sink.put('\n');
+    }
+    return sink.close();
+}
+
+bool DatasetWriter::finish() {
+    bool success = finishColumn(ids, "<i4");
+    success = finishColumn(types, "<i4") && success;
+    success = finishColumn(lines, "<i4") && success;
+    success = finishColumn(columns, "<i4") && success;
+    success = writeOffsets() && success;
+    success = writeVocabulary() && success;
+    success = writeTypes() && success;
+    return writeFiles() && success;
+}
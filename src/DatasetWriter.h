@@ -0,0 +1,113 @@
+#ifndef DATASET_WRITER_H
+#define DATASET_WRITER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include "Token.h"
+#include "OutputSink.h"
+
+// Lexemes interned to dense ids (in order of first occurrence) with the
+// number of times each was seen
+class LexemeVocabulary {
+private:
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<const std::string*> lexemes;
+    std::vector<uint64_t> counts;
+
+public:
+    // Id of a lexeme, adding it if needed; its count grows by count
+    uint32_t intern(const std::string& lexeme, uint64_t count = 1);
+
+    size_t size() const { return lexemes.size(); }
+    const std::string& lexeme(uint32_t id) const { return *lexemes[id]; }
+    uint64_t count(uint32_t id) const { return counts[id]; }
+};
+
+// Token columns of one source file, with ids local to its own vocabulary
+// so files can be collected on separate threads
+struct DatasetDocument {
+    std::string filename;
+    LexemeVocabulary vocabulary;
+    std::vector<int32_t> ids;
+    std::vector<int32_t> types;
+    std::vector<int32_t> lines;
+    std::vector<int32_t> columns;
+    size_t errors = 0;
+
+    void add(const Token& token);
+    size_t size() const { return ids.size(); }
+};
+
+// Writes lexer output as training-ready arrays. A dataset directory holds
+// one int32 column per token field plus the tables needed to decode them:
+//
+//   tokens.npy   vocabulary id of each token's lexeme
+//   types.npy    TokenType value
+//   lines.npy    line number
+//   columns.npy  column number
+//   offsets.npy  int64 index of each file's first token (files + 1 entries)
+//   vocab.tsv    id, count and JSON-escaped lexeme per vocabulary entry
+//   types.tsv    id and name of every TokenType
+//   files.tsv    index, token count and path of every file
+//
+// The RAW format writes the same columns as headerless little-endian
+// .i32/.i64 files. Documents must be added in file order; vocabulary ids
+// are then the same however the documents were produced.
+class DatasetWriter {
+public:
+    enum class Format {
+        NPY,
+        RAW
+    };
+
+    static bool parseFormat(const std::string& name, Format& format);
+
+private:
+    struct Column {
+        std::string name;
+        std::unique_ptr<FileSink> sink;
+        size_t count = 0;
+    };
+
+    std::string directory;
+    Format format;
+    Column ids;
+    Column types;
+    Column lines;
+    Column columns;
+    LexemeVocabulary vocabulary;
+    std::vector<int64_t> offsets;
+    std::vector<std::pair<std::string, size_t>> files;
+    size_t tokenCount;
+
+    std::string path(const std::string& name) const;
+    bool openColumn(Column& column, const std::string& name);
+    void appendColumn(Column& column, const std::vector<int32_t>& values);
+    bool finishColumn(Column& column, const char* descr);
+    bool writeOffsets();
+    bool writeVocabulary() const;
+    bool writeTypes() const;
+    bool writeFiles() const;
+
+public:
+    DatasetWriter(const std::string& directory, Format format = Format::NPY);
+
+    // Create the directory and the column files
+    bool open();
+
+    // Append a file's tokens; its lexeme ids are remapped to the shared
+    // vocabulary in place
+    void addDocument(DatasetDocument& document);
+
+    // Complete the columns and write the tables; false on any I/O error
+    bool finish();
+
+    size_t documentCount() const { return files.size(); }
+    size_t size() const { return tokenCount; }
+    size_t vocabularySize() const { return vocabulary.size(); }
+};
+
+#endif // DATASET_WRITER_H
@@ -0,0 +1,145 @@
+#include "Escape.h"
+#include "ByteScan.h"
+#include <cstring>
+
+namespace {
+
+const size_t SHORT_RUN = 16;
+
+// Replacement strings for one output format, indexed by byte value
+struct EscapeTable {
+    ByteSet special;
+    std::string replacement[256];
+
+    EscapeTable(std::string_view members, unsigned char below)
+        : special(members, below) {}
+};
+
+EscapeTable makeJsonTable() {
+    static const char hexDigits[] = "0123456789abcdef";
+    EscapeTable table("\"\\", 0x20);
+    for (int c = 0; c < 0x20; ++c) {
+        table.replacement[c] = std::string("\\u00") + hexDigits[c >> 4] + hexDigits[c & 0xF];
+    }
+    table.replacement[static_cast<unsigned char>('"')] = "\\\"";
+    table.replacement[static_cast<unsigned char>('\\')] = "\\\\";
+    table.replacement[static_cast<unsigned char>('\b')] = "\\b";
+    table.replacement[static_cast<unsigned char>('\f')] = "\\f";
+    table.replacement[static_cast<unsigned char>('\n')] = "\\n";
+    table.replacement[static_cast<unsigned char>('\r')] = "\\r";
+    table.replacement[static_cast<unsigned char>('\t')] = "\\t";
+    return table;
+}
+
+EscapeTable makeXmlTable() {
+    EscapeTable table("&<>\"'", 0);
+    table.replacement[static_cast<unsigned char>('&')] = "&amp;";
+    table.replacement[static_cast<unsigned char>('<')] = "&lt;";
+    table.replacement[static_cast<unsigned char>('>')] = "&gt;";
+    table.replacement[static_cast<unsigned char>('"')] = "&quot;";
+    table.replacement[static_cast<unsigned char>('\'')] = "&apos;";
+    return table;
+}
+
+EscapeTable makeCsvTable() {
+    EscapeTable table("\"", 0);
+    table.replacement[static_cast<unsigned char>('"')] = "\"\"";
+    return table;
+}
+
+EscapeTable makeHtmlTable() {
+    EscapeTable table("&<>\"'\n\t ", 0);
+    table.replacement[static_cast<unsigned char>('&')] = "&amp;";
+    table.replacement[static_cast<unsigned char>('<')] = "&lt;";
+    table.replacement[static_cast<unsigned char>('>')] = "&gt;";
+    table.replacement[static_cast<unsigned char>('"')] = "&quot;";
+    table.replacement[static_cast<unsigned char>('\'')] = "&#39;";
+    table.replacement[static_cast<unsigned char>('\n')] = "<br>";
+    table.replacement[static_cast<unsigned char>('\t')] = "&nbsp;&nbsp;&nbsp;&nbsp;";
+    table.replacement[static_cast<unsigned char>(' ')] = "&nbsp;";
+    return table;
+}
+
+const EscapeTable& tableFor(Escape::Format format) {
+    static const EscapeTable json = makeJsonTable();
+    static const EscapeTable xml = makeXmlTable();
+    static const EscapeTable csv = makeCsvTable();
+    static const EscapeTable html = makeHtmlTable();
+
+    switch (format) {
+        case Escape::Format::JSON: return json;
+        case Escape::Format::XML: return xml;
+        case Escape::Format::CSV: return csv;
+        case Escape::Format::HTML: return html;
+    }
+    return json;
+}
+
+// Walk the input, handing clean runs and replacements to the output
+template <typename Output>
+void escapeInto(Output& output, std::string_view input, Escape::Format format) {
+    const EscapeTable& table = tableFor(format);
+    const char* data = input.data();
+    size_t size = input.size();
+
+    while (size > 0) {
+        // Dense inputs (HTML spaces, quoted strings) have short clean runs;
+        // check a few bytes directly before paying for a vector scan
+        size_t run = 0;
+        size_t probe = size < SHORT_RUN ? size : SHORT_RUN;
+        while (run < probe && !table.special.contains(static_cast<unsigned char>(data[run]))) {
+            ++run;
+        }
+        if (run == probe && run < size) {
+            run += findFirstOf(data + run, size - run, table.special);
+        }
+        if (run > 0) {
+            output(std::string_view(data, run));
+        }
+        if (run == size) {
+            break;
+        }
+        output(std::string_view(table.replacement[static_cast<unsigned char>(data[run])]));
+        data += run + 1;
+        size -= run + 1;
+    }
+}
+
+} // namespace
+
+size_t Escape::findEscapable(std::string_view input, Format format) {
+    return findFirstOf(input.data(), input.size(), tableFor(format).special);
+}
+
+void Escape::append(std::string& output, std::string_view input, Format format) {
+    // Stage short pieces in a local buffer; std::string::append per piece is
+    // the dominant cost when clean runs are only a few bytes long
+    char staging[1024];
+    size_t used = 0;
+    auto appendRun = [&](std::string_view run) {
+        if (used + run.size() > sizeof(staging)) {
+            output.append(staging, used);
+            used = 0;
+            if (run.size() > sizeof(staging)) {
+                output.append(run.data(), run.size());
+                return;
+            }
+        }
+        std::memcpy(staging + used, run.data(), run.size());
+        used += run.size();
+    };
+    escapeInto(appendRun, input, format);
+    output.append(staging, used);
+}
+
+void Escape::write(OutputSink& sink, std::string_view input, Format format) {
+    auto writeRun = [&sink](std::string_view run) { sink.write(run); };
+    escapeInto(writeRun, input, format);
+}
+
+std::string Escape::escape(std::string_view input, Format format) {
+    std::string output;
+    output.reserve(input.size() + input.size() / 8);
+    append(output, input, format);
+    return output;
+}
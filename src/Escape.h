@@ -0,0 +1,29 @@
+#ifndef ESCAPE_H
+#define ESCAPE_H
+
+#include <string>
+#include <string_view>
+#include "OutputSink.h"
+
+// Output escaping shared by the exporters and the WebAssembly bindings.
+// Each format has a replacement table; clean runs between characters that
+// need escaping are found with a vectorized scan and copied in bulk.
+namespace Escape {
+    enum class Format {
+        JSON,   // string contents: quotes, backslashes, control characters
+        XML,    // & < > " '
+        CSV,    // doubled quotes inside a quoted field
+        HTML    // & < > " ' plus visible whitespace (<br>, &nbsp;)
+    };
+
+    // Index of the first character that needs escaping, or input.size()
+    size_t findEscapable(std::string_view input, Format format);
+
+    // Append the escaped form of input
+    void append(std::string& output, std::string_view input, Format format);
+    void write(OutputSink& sink, std::string_view input, Format format);
+
+    std::string escape(std::string_view input, Format format);
+}
+
+#endif // ESCAPE_H
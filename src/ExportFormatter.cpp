@@ -1,281 +1,960 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdio>
+#include <unistd.h>
 #include "ExportFormatter.h"
-#include <sstream>
-#include <iomanip>
+#include "BinaryTokenFormat.h"
+#include "HtmlPagesExporter.h"
+#include "Escape.h"
+#include "ThreadPool.h"
 
-// JSON Exporter implementation
-std::string JsonExporter::exportToString(const std::vector<Token>& tokens) const {
-    std::stringstream ss;
-    
-    ss << "{\n";
-    ss << "  \"tokens\": [\n";
-    
-    for (size_t i = 0; i < tokens.size(); ++i) {
-        const Token& token = tokens[i];
-        
-        ss << "    {\n";
-        ss << "      \"type\": \"" << token.typeToString() << "\",\n";
-        ss << "      \"lexeme\": \"" << token.lexeme << "\",\n";
-        ss << "      \"line\": " << token.location.line << ",\n";
-        ss << "      \"column\": " << token.location.column << ",\n";
-        
-        if (!token.location.filename.empty()) {
-            ss << "      \"filename\": \"" << token.location.filename << "\"";
-        }
-        
-        if (token.attribute) {
-            ss << ",\n      \"attributes\": " << token.attribute->toString();
-        }
-        
-        ss << "\n    }";
-        
-        if (i < tokens.size() - 1) {
-            ss << ",";
-        }
-        
-        ss << "\n";
-    }
-    
-    ss << "  ]\n";
-    ss << "}\n";
-    
-    return ss.str();
+// ExportField implementation
+bool ExportField::parse(const std::string& list, ExportFields& fields) {
+    ExportFields parsed = 0;
+    size_t start = 0;
+
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        std::string name = list.substr(start, end - start);
+
+        if (name == "type") {
+            parsed |= TYPE;
+        } else if (name == "lexeme") {
+            parsed |= LEXEME;
+        } else if (name == "line") {
+            parsed |= LINE;
+        } else if (name == "column") {
+            parsed |= COLUMN;
+        } else if (name == "position") {
+            parsed |= LINE | COLUMN;
+        } else if (name == "filename" || name == "file") {
+            parsed |= FILENAME;
+        } else if (name == "attributes" || name == "attrs") {
+            parsed |= ATTRIBUTES;
+        } else if (name == "all") {
+            parsed |= ALL;
+        } else {
+            return false;
+        }
+        start = end + 1;
+    }
+
+    fields = parsed;
+    return parsed != 0;
 }
 
-// XML Exporter implementation
-std::string XmlExporter::exportToString(const std::vector<Token>& tokens) const {
-    std::stringstream ss;
-    
-    ss << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-    ss << "<tokens>\n";
-    
-    for (const auto& token : tokens) {
-        ss << "  <token>\n";
-        ss << "    <type>" << token.typeToString() << "</type>\n";
-        ss << "    <lexeme>" << escapeXml(token.lexeme) << "</lexeme>\n";
-        ss << "    <location>\n";
-        ss << "      <line>" << token.location.line << "</line>\n";
-        ss << "      <column>" << token.location.column << "</column>\n";
-        
-        if (!token.location.filename.empty()) {
-            ss << "      <filename>" << token.location.filename << "</filename>\n";
-        }
-        
-        ss << "    </location>\n";
-        
-        if (token.attribute) {
-            ss << "    <attributes>" << escapeXml(token.attribute->toString()) << "</attributes>\n";
-        }
-        
-        ss << "  </token>\n";
-    }
-    
-    ss << "</tokens>\n";
-    
-    return ss.str();
+// TokenExporter implementation
+std::unique_ptr<TokenWriter> TokenExporter::openFile(const std::string& filename) const {
+    auto sink = filename == "-" ? std::make_unique<FileSink>(STDOUT_FILENO)
+                                : std::make_unique<FileSink>(filename);
+    if (!sink->isOpen()) {
+        return nullptr;
+    }
+
+    auto writer = createWriter(*sink);
+    writer->adoptSink(std::move(sink));
+    return writer;
 }
 
-// Helper method to escape XML special characters
-std::string XmlExporter::escapeXml(const std::string& input) const {
-    std::string output;
-    output.reserve(input.size());
-    
-    for (char c : input) {
-        switch (c) {
-            case '&': output += "&amp;"; break;
-            case '<': output += "&lt;"; break;
-            case '>': output += "&gt;"; break;
-            case '\"': output += "&quot;"; break;
-            case '\'': output += "&apos;"; break;
-            default: output += c; break;
-        }
-    }
-    
-    return output;
+std::string TokenExporter::exportToString(const std::vector<Token>& tokens) const {
+    std::string result;
+    {
+        StringSink sink(result);
+        auto writer = createWriter(sink);
+        writer->begin();
+        for (const auto& token : tokens) {
+            writer->write(token);
+        }
+        writer->finish();
+    }
+    return result;
 }
 
-// CSV Exporter implementation
-std::string CsvExporter::exportToString(const std::vector<Token>& tokens) const {
-    std::stringstream ss;
-    
-    // Add headers if requested
-    if (includeHeaders) {
-        ss << "Type" << delimiter
-           << "Lexeme" << delimiter
-           << "Line" << delimiter
-           << "Column" << delimiter
-           << "Filename" << delimiter
-           << "Attributes" << "\n";
-    }
-    
-    // Add token data
+bool TokenExporter::exportToFile(const std::vector<Token>& tokens, const std::string& filename) const {
+    auto writer = openFile(filename);
+    if (!writer) {
+        return false;
+    }
+
+    writer->begin();
     for (const auto& token : tokens) {
-        ss << token.typeToString() << delimiter
-           << "\"" << escapeCsv(token.lexeme) << "\"" << delimiter
-           << token.location.line << delimiter
-           << token.location.column << delimiter
-           << "\"" << escapeCsv(token.location.filename) << "\"" << delimiter;
-        
-        if (token.attribute) {
-            ss << "\"" << escapeCsv(token.attribute->toString()) << "\"";
-        }
-        
-        ss << "\n";
-    }
-    
-    return ss.str();
+        writer->write(token);
+    }
+    return writer->finish();
 }
 
-// Helper method to escape CSV special characters
-std::string CsvExporter::escapeCsv(const std::string& input) const {
-    std::string output;
-    output.reserve(input.size());
-    
-    for (char c : input) {
-        output += c;
-        if (c == '\"') {
-            output += '\"'; // Double quotation marks
-        }
-    }
-    
-    return output;
+namespace {
+
+// Tokens per independently formatted chunk, and chunks per thread kept in
+// memory at once (a "wave") during a parallel export
+const size_t PARALLEL_CHUNK_TOKENS = 32 * 1024;
+const size_t PARALLEL_CHUNKS_PER_THREAD = 2;
+
+} // namespace
+
+bool TokenExporter::exportToFileParallel(const std::vector<Token>& tokens, const std::string& filename,
+                                         ThreadPool& pool) const {
+    if (pool.size() <= 1 || !supportsChunkedExport() || tokens.size() < 2 * PARALLEL_CHUNK_TOKENS) {
+        return exportToFile(tokens, filename);
+    }
+
+    auto sink = filename == "-" ? std::make_unique<FileSink>(STDOUT_FILENO)
+                                : std::make_unique<FileSink>(filename);
+    if (!sink->isOpen()) {
+        return false;
+    }
+
+    // Regular files are written with pwrite from the workers; stdout may be
+    // a pipe, so its chunks go through the sink in order instead
+    const bool positional = filename != "-";
+    size_t position = 0;
+    bool ok = true;
+    auto emit = [&](const std::string& part) {
+        if (positional) {
+            ok = sink->writeAt(part.data(), part.size(), position) && ok;
+        } else {
+            sink->write(part);
+        }
+        position += part.size();
+    };
+
+    std::string header;
+    {
+        StringSink headerSink(header);
+        auto writer = createWriter(headerSink);
+        writer->begin();
+    }
+    emit(header);
+
+    const size_t chunkCount = (tokens.size() + PARALLEL_CHUNK_TOKENS - 1) / PARALLEL_CHUNK_TOKENS;
+    const size_t waveSize = pool.size() * PARALLEL_CHUNKS_PER_THREAD;
+    std::vector<std::string> parts(waveSize);
+    std::vector<size_t> offsets(waveSize);
+    std::vector<char> written(waveSize);
+
+    for (size_t firstChunk = 0; firstChunk < chunkCount && ok; firstChunk += waveSize) {
+        size_t count = std::min(waveSize, chunkCount - firstChunk);
+
+        pool.parallelFor(count, [&](size_t i) {
+            size_t begin = (firstChunk + i) * PARALLEL_CHUNK_TOKENS;
+            size_t end = std::min(begin + PARALLEL_CHUNK_TOKENS, tokens.size());
+
+            parts[i].clear();
+            StringSink chunkSink(parts[i]);
+            auto writer = createWriter(chunkSink);
+            writer->resumeAt(begin);
+            for (size_t t = begin; t < end; ++t) {
+                writer->write(tokens[t]);
+            }
+        });
+
+        if (!positional) {
+            for (size_t i = 0; i < count; ++i) {
+                emit(parts[i]);
+            }
+            continue;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            offsets[i] = position;
+            position += parts[i].size();
+        }
+        pool.parallelFor(count, [&](size_t i) {
+            written[i] = sink->writeAt(parts[i].data(), parts[i].size(), offsets[i]);
+        });
+        for (size_t i = 0; i < count; ++i) {
+            ok = ok && written[i];
+        }
+    }
+
+    std::string footer;
+    {
+        StringSink footerSink(footer);
+        auto writer = createWriter(footerSink);
+        writer->resumeAt(tokens.size());
+        writer->finish();
+    }
+    emit(footer);
+
+    return sink->close() && ok;
 }
 
-// HTML Exporter implementation
-std::string HtmlExporter::exportToString(const std::vector<Token>& tokens) const {
-    std::stringstream ss;
-    
-    ss << "<!DOCTYPE html>\n";
-    ss << "<html>\n";
-    ss << "<head>\n";
-    ss << "  <title>Token Visualization</title>\n";
-    
-    if (includeStyles) {
-        ss << "  <style>\n";
-        ss << "    body { font-family: Arial, sans-serif; margin: 20px; }\n";
-        ss << "    table { border-collapse: collapse; width: 100%; }\n";
-        ss << "    th, td { border: 1px solid #ddd; padding: 8px; text-align: left; }\n";
-        ss << "    th { background-color: #f2f2f2; }\n";
-        ss << "    tr:nth-child(even) { background-color: #f9f9f9; }\n";
-        ss << "    .token-INTEGER { color: #0066cc; }\n";
-        ss << "    .token-FLOAT, .token-SCIENTIFIC { color: #006699; }\n";
-        ss << "    .token-HEX, .token-OCTAL, .token-BINARY { color: #9900cc; }\n";
-        ss << "    .token-STRING_LITERAL, .token-CHAR_LITERAL { color: #cc6600; }\n";
-        ss << "    .token-IDENTIFIER { color: #000000; }\n";
-        ss << "    .token-KEYWORD { color: #0000cc; font-weight: bold; }\n";
-        ss << "    .token-OPERATOR, .token-ASSIGNMENT_OPERATOR, .token-ARITHMETIC_OPERATOR,\n";
-        ss << "    .token-LOGICAL_OPERATOR, .token-BITWISE_OPERATOR, .token-COMPARISON_OPERATOR { color: #cc0000; }\n";
-        ss << "    .token-DELIMITER, .token-PARENTHESIS, .token-BRACKET, .token-BRACE,\n";
-        ss << "    .token-SEMICOLON, .token-COMMA, .token-DOT { color: #666666; }\n";
-        ss << "    .token-PREPROCESSOR { color: #009900; font-style: italic; }\n";
-        ss << "    .token-COMMENT { color: #999999; font-style: italic; }\n";
-        ss << "    .token-ERROR, .token-UNKNOWN { color: #ff0000; background-color: #ffeeee; }\n";
-        ss << "    .details { font-size: 0.8em; color: #666; margin-top: 5px; }\n";
-        ss << "  </style>\n";
-    }
-    
-    ss << "</head>\n";
-    ss << "<body>\n";
-    ss << "  <h1>Token Visualization</h1>\n";
-    ss << "  <table>\n";
-    ss << "    <tr>\n";
-    ss << "      <th>Type</th>\n";
-    ss << "      <th>Lexeme</th>\n";
-    
-    if (includeTokenDetails) {
-        ss << "      <th>Line</th>\n";
-        ss << "      <th>Column</th>\n";
-        ss << "      <th>Filename</th>\n";
-        ss << "      <th>Attributes</th>\n";
-    }
-    
-    ss << "    </tr>\n";
-    
-    for (const auto& token : tokens) {
-        ss << "    <tr>\n";
-        ss << "      <td>" << token.typeToString() << "</td>\n";
-        ss << "      <td class=\"token-" << token.typeToString() << "\">" 
-           << escapeHtml(token.lexeme) << "</td>\n";
-        
-        if (includeTokenDetails) {
-            ss << "      <td>" << token.location.line << "</td>\n";
-            ss << "      <td>" << token.location.column << "</td>\n";
-            ss << "      <td>" << escapeHtml(token.location.filename) << "</td>\n";
-            ss << "      <td>";
-            
+namespace {
+
+// JSON writer
+class JsonTokenWriter : public TokenWriter {
+public:
+    using TokenWriter::TokenWriter;
+
+protected:
+    void writeHeader() override {
+        sink.write("{\n");
+        sink.write("  \"tokens\": [\n");
+    }
+
+    // Start a member line; every member but the first follows a comma
+    void beginField(const char* name, bool& first) {
+        sink.write(first ? "      \"" : ",\n      \"");
+        sink.write(name);
+        sink.write("\": ");
+        first = false;
+    }
+
+    void writeToken(const Token& token) override {
+        if (tokenCount > 0) {
+            sink.write(",\n");
+        }
+
+        sink.write("    {\n");
+        bool first = true;
+
+        if (fields & ExportField::TYPE) {
+            beginField("type", first);
+            sink.put('"');
+            sink.write(token.typeToString());
+            sink.put('"');
+        }
+
+        if (fields & ExportField::LEXEME) {
+            beginField("lexeme", first);
+            sink.put('"');
+            Escape::write(sink, token.lexeme, Escape::Format::JSON);
+            sink.put('"');
+        }
+
+        if (fields & ExportField::LINE) {
+            beginField("line", first);
+            sink.writeInt(token.location.line);
+        }
+
+        if (fields & ExportField::COLUMN) {
+            beginField("column", first);
+            sink.writeInt(token.location.column);
+        }
+
+        if ((fields & ExportField::FILENAME) && !token.location.filename.empty()) {
+            beginField("filename", first);
+            sink.put('"');
+            Escape::write(sink, token.location.filename, Escape::Format::JSON);
+            sink.put('"');
+        }
+
+        if ((fields & ExportField::ATTRIBUTES) && token.attribute) {
+            beginField("attributes", first);
+            sink.put('"');
+            Escape::write(sink, token.attribute->toString(), Escape::Format::JSON);
+            sink.put('"');
+        }
+
+        sink.write(first ? "    }" : "\n    }");
+    }
+
+    void writeFooter() override {
+        if (tokenCount > 0) {
+            sink.put('\n');
+        }
+        sink.write("  ]\n");
+        sink.write("}\n");
+    }
+};
+
+// Columnar JSON writer: one array per field plus shared tables for type
+// names, lexemes, filenames and attribute strings. Columns are collected
+// while tokens arrive and written by the footer.
+class ColumnarJsonTokenWriter : public TokenWriter {
+private:
+    // Insertion-ordered string table
+    struct StringTable {
+        std::unordered_map<std::string, int> ids;
+        std::vector<const std::string*> values;
+
+        int intern(const std::string& text) {
+            auto it = ids.find(text);
+            if (it != ids.end()) {
+                return it->second;
+            }
+            int id = static_cast<int>(values.size());
+            values.push_back(&ids.emplace(text, id).first->first);
+            return id;
+        }
+    };
+
+    std::vector<int> typeIndex;
+    std::vector<std::string> typeTable;
+    StringTable lexemeTable;
+    StringTable filenameTable;
+    StringTable attributeTable;
+
+    std::vector<int> types;
+    std::vector<int> lexemes;
+    std::vector<int> lines;
+    std::vector<int> columns;
+    std::vector<int> filenames;
+    std::vector<int> attributes;
+
+    void writeNumbers(const char* name, const std::vector<int>& values) {
+        sink.write(",\n  \"");
+        sink.write(name);
+        sink.write("\": [");
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i > 0) {
+                sink.put(',');
+            }
+            sink.writeInt(values[i]);
+        }
+        sink.put(']');
+    }
+
+    void writeStrings(const char* name, const std::vector<const std::string*>& values) {
+        sink.write(",\n  \"");
+        sink.write(name);
+        sink.write("\": [");
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i > 0) {
+                sink.put(',');
+            }
+            sink.put('"');
+            Escape::write(sink, *values[i], Escape::Format::JSON);
+            sink.put('"');
+        }
+        sink.put(']');
+    }
+
+public:
+    ColumnarJsonTokenWriter(OutputSink& sink, ExportFields fields)
+        : TokenWriter(sink, fields), typeIndex(256, -1) {}
+
+protected:
+    void writeHeader() override {
+        sink.write("{\n");
+        sink.write("  \"layout\": \"columnar\"");
+    }
+
+    void writeToken(const Token& token) override {
+        if (fields & ExportField::TYPE) {
+            int& index = typeIndex[static_cast<uint8_t>(token.type)];
+            if (index < 0) {
+                index = static_cast<int>(typeTable.size());
+                typeTable.push_back(token.typeToString());
+            }
+            types.push_back(index);
+        }
+        if (fields & ExportField::LEXEME) {
+            lexemes.push_back(lexemeTable.intern(token.lexeme));
+        }
+        if (fields & ExportField::LINE) {
+            lines.push_back(token.location.line);
+        }
+        if (fields & ExportField::COLUMN) {
+            columns.push_back(token.location.column);
+        }
+        if (fields & ExportField::FILENAME) {
+            filenames.push_back(filenameTable.intern(token.location.filename));
+        }
+        if (fields & ExportField::ATTRIBUTES) {
+            attributes.push_back(token.attribute ? attributeTable.intern(token.attribute->toString()) : -1);
+        }
+    }
+
+    void writeFooter() override {
+        sink.write(",\n  \"count\": ");
+        sink.writeUInt(tokenCount);
+
+        if (fields & ExportField::TYPE) {
+            sink.write(",\n  \"typeTable\": [");
+            for (size_t i = 0; i < typeTable.size(); ++i) {
+                if (i > 0) {
+                    sink.put(',');
+                }
+                sink.put('"');
+                sink.write(typeTable[i]);
+                sink.put('"');
+            }
+            sink.put(']');
+            writeNumbers("type", types);
+        }
+        if (fields & ExportField::LEXEME) {
+            writeStrings("lexemeTable", lexemeTable.values);
+            writeNumbers("lexeme", lexemes);
+        }
+        if (fields & ExportField::LINE) {
+            writeNumbers("line", lines);
+        }
+        if (fields & ExportField::COLUMN) {
+            writeNumbers("column", columns);
+        }
+        if (fields & ExportField::FILENAME) {
+            writeStrings("filenameTable", filenameTable.values);
+            writeNumbers("filename", filenames);
+        }
+        if (fields & ExportField::ATTRIBUTES) {
+            writeStrings("attributeTable", attributeTable.values);
+            writeNumbers("attribute", attributes);
+        }
+
+        sink.write("\n}\n");
+    }
+};
+
+// NDJSON writer
+class NdjsonTokenWriter : public TokenWriter {
+private:
+    bool groupByFile;
+    bool inFile;
+    std::string currentFile;
+
+    void beginField(const char* name, bool& first) {
+        sink.write(first ? "\"" : ",\"");
+        sink.write(name);
+        sink.write("\":");
+        first = false;
+    }
+
+    void writeObject(const Token& token, bool includeFilename) {
+        sink.put('{');
+        bool first = true;
+
+        if (fields & ExportField::TYPE) {
+            beginField("type", first);
+            sink.put('"');
+            sink.write(token.typeToString());
+            sink.put('"');
+        }
+
+        if (fields & ExportField::LEXEME) {
+            beginField("lexeme", first);
+            sink.put('"');
+            Escape::write(sink, token.lexeme, Escape::Format::JSON);
+            sink.put('"');
+        }
+
+        if (fields & ExportField::LINE) {
+            beginField("line", first);
+            sink.writeInt(token.location.line);
+        }
+
+        if (fields & ExportField::COLUMN) {
+            beginField("column", first);
+            sink.writeInt(token.location.column);
+        }
+
+        if (includeFilename && (fields & ExportField::FILENAME) && !token.location.filename.empty()) {
+            beginField("filename", first);
+            sink.put('"');
+            Escape::write(sink, token.location.filename, Escape::Format::JSON);
+            sink.put('"');
+        }
+
+        if ((fields & ExportField::ATTRIBUTES) && token.attribute) {
+            beginField("attributes", first);
+            sink.put('"');
+            Escape::write(sink, token.attribute->toString(), Escape::Format::JSON);
+            sink.put('"');
+        }
+
+        sink.put('}');
+    }
+
+    void closeFile() {
+        if (inFile) {
+            sink.write("]}\n");
+            inFile = false;
+        }
+    }
+
+public:
+    NdjsonTokenWriter(OutputSink& sink, ExportFields fields, bool groupByFile)
+        : TokenWriter(sink, fields), groupByFile(groupByFile), inFile(false) {}
+
+protected:
+    void writeToken(const Token& token) override {
+        if (!groupByFile) {
+            writeObject(token, true);
+            sink.put('\n');
+            return;
+        }
+
+        // One line per source file; a new line starts whenever the file changes
+        if (!inFile || token.location.filename != currentFile) {
+            closeFile();
+            currentFile = token.location.filename;
+            sink.write("{\"filename\":\"");
+            Escape::write(sink, currentFile, Escape::Format::JSON);
+            sink.write("\",\"tokens\":[");
+            inFile = true;
+        } else {
+            sink.put(',');
+        }
+        writeObject(token, false);
+    }
+
+    void writeFooter() override {
+        closeFile();
+    }
+};
+
+// XML writer
+class XmlTokenWriter : public TokenWriter {
+public:
+    using TokenWriter::TokenWriter;
+
+protected:
+    void writeHeader() override {
+        sink.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+        sink.write("<tokens>\n");
+    }
+
+    void writeToken(const Token& token) override {
+        sink.write("  <token>\n");
+
+        if (fields & ExportField::TYPE) {
+            sink.write("    <type>");
+            sink.write(token.typeToString());
+            sink.write("</type>\n");
+        }
+
+        if (fields & ExportField::LEXEME) {
+            sink.write("    <lexeme>");
+            Escape::write(sink, token.lexeme, Escape::Format::XML);
+            sink.write("</lexeme>\n");
+        }
+
+        if (fields & (ExportField::LINE | ExportField::COLUMN | ExportField::FILENAME)) {
+            sink.write("    <location>\n");
+
+            if (fields & ExportField::LINE) {
+                sink.write("      <line>");
+                sink.writeInt(token.location.line);
+                sink.write("</line>\n");
+            }
+
+            if (fields & ExportField::COLUMN) {
+                sink.write("      <column>");
+                sink.writeInt(token.location.column);
+                sink.write("</column>\n");
+            }
+
+            if ((fields & ExportField::FILENAME) && !token.location.filename.empty()) {
+                sink.write("      <filename>");
+                Escape::write(sink, token.location.filename, Escape::Format::XML);
+                sink.write("</filename>\n");
+            }
+
+            sink.write("    </location>\n");
+        }
+
+        if ((fields & ExportField::ATTRIBUTES) && token.attribute) {
+            sink.write("    <attributes>");
+            Escape::write(sink, token.attribute->toString(), Escape::Format::XML);
+            sink.write("</attributes>\n");
+        }
+
+        sink.write("  </token>\n");
+    }
+
+    void writeFooter() override {
+        sink.write("</tokens>\n");
+    }
+};
+
+// CSV writer
+class CsvTokenWriter : public TokenWriter {
+private:
+    bool includeHeaders;
+    char delimiter;
+
+    // Separate columns; the first selected column has no delimiter
+    void beginColumn(bool& first) {
+        if (!first) {
+            sink.put(delimiter);
+        }
+        first = false;
+    }
+
+public:
+    CsvTokenWriter(OutputSink& sink, ExportFields fields, bool includeHeaders, char delimiter)
+        : TokenWriter(sink, fields), includeHeaders(includeHeaders), delimiter(delimiter) {}
+
+protected:
+    void writeHeader() override {
+        // Add headers if requested
+        if (includeHeaders) {
+            static const struct {
+                ExportFields field;
+                const char* title;
+            } columns[] = {
+                {ExportField::TYPE, "Type"},
+                {ExportField::LEXEME, "Lexeme"},
+                {ExportField::LINE, "Line"},
+                {ExportField::COLUMN, "Column"},
+                {ExportField::FILENAME, "Filename"},
+                {ExportField::ATTRIBUTES, "Attributes"},
+            };
+
+            bool first = true;
+            for (const auto& column : columns) {
+                if (fields & column.field) {
+                    beginColumn(first);
+                    sink.write(column.title);
+                }
+            }
+            sink.put('\n');
+        }
+    }
+
+    void writeToken(const Token& token) override {
+        bool first = true;
+
+        if (fields & ExportField::TYPE) {
+            beginColumn(first);
+            sink.write(token.typeToString());
+        }
+
+        if (fields & ExportField::LEXEME) {
+            beginColumn(first);
+            sink.put('"');
+            Escape::write(sink, token.lexeme, Escape::Format::CSV);
+            sink.put('"');
+        }
+
+        if (fields & ExportField::LINE) {
+            beginColumn(first);
+            sink.writeInt(token.location.line);
+        }
+
+        if (fields & ExportField::COLUMN) {
+            beginColumn(first);
+            sink.writeInt(token.location.column);
+        }
+
+        if (fields & ExportField::FILENAME) {
+            beginColumn(first);
+            sink.put('"');
+            Escape::write(sink, token.location.filename, Escape::Format::CSV);
+            sink.put('"');
+        }
+
+        if (fields & ExportField::ATTRIBUTES) {
+            beginColumn(first);
             if (token.attribute) {
-                ss << escapeHtml(token.attribute->toString());
+                sink.put('"');
+                Escape::write(sink, token.attribute->toString(), Escape::Format::CSV);
+                sink.put('"');
             }
-            
-            ss << "</td>\n";
-        }
-        
-        ss << "    </tr>\n";
-    }
-    
-    ss << "  </table>\n";
-    
-    // Add token stream visualization
-    ss << "  <h2>Token Stream</h2>\n";
-    ss << "  <div class=\"token-stream\">\n";
-    
-    for (const auto& token : tokens) {
-        if (token.type == TokenType::EOF_TOKEN) {
-            continue; // Skip EOF in visualization
         }
-        
-        ss << "    <span class=\"token-" << token.typeToString() << "\">" 
-           << escapeHtml(token.lexeme);
-        
+
+        sink.put('\n');
+    }
+};
+
+// HTML writer. The "Token Stream" section follows the table, so its spans
+// are spilled to a temporary file while the table streams out and copied
+// behind it when the export finishes.
+class HtmlTokenWriter : public TokenWriter {
+private:
+    bool includeStyles;
+    bool includeTokenDetails;
+    std::FILE* spill;
+    std::string spillFallback;
+
+    // A short write (e.g. a full disk) would truncate the token stream, so
+    // it fails the export
+    void writeSpill(const std::string& text) {
+        if (spill) {
+            if (std::fwrite(text.data(), 1, text.size(), spill) != text.size()) {
+                failed = true;
+            }
+        } else {
+            spillFallback += text;
+        }
+    }
+
+public:
+    HtmlTokenWriter(OutputSink& sink, ExportFields fields, bool includeStyles, bool includeTokenDetails)
+        : TokenWriter(sink, fields), includeStyles(includeStyles), includeTokenDetails(includeTokenDetails),
+          spill(std::tmpfile()) {}
+
+    ~HtmlTokenWriter() override {
+        if (spill) {
+            std::fclose(spill);
+        }
+    }
+
+protected:
+    void writeHeader() override {
+        sink.write("<!DOCTYPE html>\n");
+        sink.write("<html>\n");
+        sink.write("<head>\n");
+        sink.write("  <title>Token Visualization</title>\n");
+
+        if (includeStyles) {
+            sink.write("  <style>\n");
+            sink.write("    body { font-family: Arial, sans-serif; margin: 20px; }\n");
+            sink.write("    table { border-collapse: collapse; width: 100%; }\n");
+            sink.write("    th, td { border: 1px solid #ddd; padding: 8px; text-align: left; }\n");
+            sink.write("    th { background-color: #f2f2f2; }\n");
+            sink.write("    tr:nth-child(even) { background-color: #f9f9f9; }\n");
+            sink.write("    .token-INTEGER { color: #0066cc; }\n");
+            sink.write("    .token-FLOAT, .token-SCIENTIFIC { color: #006699; }\n");
+            sink.write("    .token-HEX, .token-OCTAL, .token-BINARY { color: #9900cc; }\n");
+            sink.write("    .token-STRING_LITERAL, .token-CHAR_LITERAL { color: #cc6600; }\n");
+            sink.write("    .token-IDENTIFIER { color: #000000; }\n");
+            sink.write("    .token-KEYWORD { color: #0000cc; font-weight: bold; }\n");
+            sink.write("    .token-OPERATOR, .token-ASSIGNMENT_OPERATOR, .token-ARITHMETIC_OPERATOR,\n");
+            sink.write("    .token-LOGICAL_OPERATOR, .token-BITWISE_OPERATOR, .token-COMPARISON_OPERATOR { color: #cc0000; }\n");
+            sink.write("    .token-DELIMITER, .token-PARENTHESIS, .token-BRACKET, .token-BRACE,\n");
+            sink.write("    .token-SEMICOLON, .token-COMMA, .token-DOT { color: #666666; }\n");
+            sink.write("    .token-PREPROCESSOR { color: #009900; font-style: italic; }\n");
+            sink.write("    .token-COMMENT { color: #999999; font-style: italic; }\n");
+            sink.write("    .token-ERROR, .token-UNKNOWN { color: #ff0000; background-color: #ffeeee; }\n");
+            sink.write("    .details { font-size: 0.8em; color: #666; margin-top: 5px; }\n");
+            sink.write("  </style>\n");
+        }
+
+        sink.write("</head>\n");
+        sink.write("<body>\n");
+        sink.write("  <h1>Token Visualization</h1>\n");
+        sink.write("  <table>\n");
+        sink.write("    <tr>\n");
+
+        if (fields & ExportField::TYPE) {
+            sink.write("      <th>Type</th>\n");
+        }
+        if (fields & ExportField::LEXEME) {
+            sink.write("      <th>Lexeme</th>\n");
+        }
+
+        if (includeTokenDetails) {
+            if (fields & ExportField::LINE) {
+                sink.write("      <th>Line</th>\n");
+            }
+            if (fields & ExportField::COLUMN) {
+                sink.write("      <th>Column</th>\n");
+            }
+            if (fields & ExportField::FILENAME) {
+                sink.write("      <th>Filename</th>\n");
+            }
+            if (fields & ExportField::ATTRIBUTES) {
+                sink.write("      <th>Attributes</th>\n");
+            }
+        }
+
+        sink.write("    </tr>\n");
+    }
+
+    void writeToken(const Token& token) override {
+        std::string typeName = token.typeToString();
+
+        sink.write("    <tr>\n");
+
+        if (fields & ExportField::TYPE) {
+            sink.write("      <td>");
+            sink.write(typeName);
+            sink.write("</td>\n");
+        }
+
+        if (fields & ExportField::LEXEME) {
+            sink.write("      <td class=\"token-");
+            sink.write(typeName);
+            sink.write("\">");
+            Escape::write(sink, token.lexeme, Escape::Format::HTML);
+            sink.write("</td>\n");
+        }
+
         if (includeTokenDetails) {
-            ss << "<span class=\"details\">[" << token.typeToString() << "]</span>";
+            if (fields & ExportField::LINE) {
+                sink.write("      <td>");
+                sink.writeInt(token.location.line);
+                sink.write("</td>\n");
+            }
+
+            if (fields & ExportField::COLUMN) {
+                sink.write("      <td>");
+                sink.writeInt(token.location.column);
+                sink.write("</td>\n");
+            }
+
+            if (fields & ExportField::FILENAME) {
+                sink.write("      <td>");
+                Escape::write(sink, token.location.filename, Escape::Format::HTML);
+                sink.write("</td>\n");
+            }
+
+            if (fields & ExportField::ATTRIBUTES) {
+                sink.write("      <td>");
+
+                if (token.attribute) {
+                    Escape::write(sink, token.attribute->toString(), Escape::Format::HTML);
+                }
+
+                sink.write("</td>\n");
+            }
+        }
+
+        sink.write("    </tr>\n");
+
+        // Queue the span for the token stream visualization (EOF is skipped);
+        // the stream shows lexemes, so it is left empty without them
+        if ((fields & ExportField::LEXEME) && token.type != TokenType::EOF_TOKEN) {
+            std::string span;
+            span.reserve(64 + token.lexeme.size());
+            span.append("    <span class=\"token-").append(typeName).append("\">");
+            Escape::append(span, token.lexeme, Escape::Format::HTML);
+            if (includeTokenDetails) {
+                span.append("<span class=\"details\">[").append(typeName).append("]</span>");
+            }
+            span.append("</span>\n");
+            writeSpill(span);
         }
-        
-        ss << "</span>\n";
     }
-    
-    ss << "  </div>\n";
-    ss << "</body>\n";
-    ss << "</html>\n";
-    
-    return ss.str();
+
+    void writeFooter() override {
+        sink.write("  </table>\n");
+
+        // Add token stream visualization
+        sink.write("  <h2>Token Stream</h2>\n");
+        sink.write("  <div class=\"token-stream\">\n");
+
+        if (spill) {
+            char chunk[64 * 1024];
+            if (std::fflush(spill) != 0) {
+                failed = true;
+            }
+            std::rewind(spill);
+            size_t count;
+            while ((count = std::fread(chunk, 1, sizeof(chunk), spill)) > 0) {
+                sink.write(chunk, count);
+            }
+            if (std::ferror(spill)) {
+                failed = true;
+            }
+        } else {
+            sink.write(spillFallback);
+        }
+
+        sink.write("  </div>\n");
+        sink.write("</body>\n");
+        sink.write("</html>\n");
+    }
+};
+
+} // namespace
+
+// JSON Exporter implementation
+std::unique_ptr<TokenWriter> JsonExporter::createWriter(OutputSink& sink) const {
+    return std::make_unique<JsonTokenWriter>(sink, fields);
+}
+
+// Helper method to escape JSON string contents
+std::string JsonExporter::escapeJson(const std::string& input) {
+    return Escape::escape(input, Escape::Format::JSON);
+}
+
+// Columnar JSON Exporter implementation
+std::unique_ptr<TokenWriter> ColumnarJsonExporter::createWriter(OutputSink& sink) const {
+    return std::make_unique<ColumnarJsonTokenWriter>(sink, fields);
+}
+
+// NDJSON Exporter implementation
+std::unique_ptr<TokenWriter> NdjsonExporter::createWriter(OutputSink& sink) const {
+    return std::make_unique<NdjsonTokenWriter>(sink, fields, groupByFile);
+}
+
+// XML Exporter implementation
+std::unique_ptr<TokenWriter> XmlExporter::createWriter(OutputSink& sink) const {
+    return std::make_unique<XmlTokenWriter>(sink, fields);
+}
+
+// Helper method to escape XML special characters
+std::string XmlExporter::escapeXml(const std::string& input) {
+    return Escape::escape(input, Escape::Format::XML);
+}
+
+// CSV Exporter implementation
+std::unique_ptr<TokenWriter> CsvExporter::createWriter(OutputSink& sink) const {
+    return std::make_unique<CsvTokenWriter>(sink, fields, includeHeaders, delimiter);
+}
+
+// Helper method to escape CSV special characters
+std::string CsvExporter::escapeCsv(const std::string& input) {
+    return Escape::escape(input, Escape::Format::CSV);
+}
+
+// HTML Exporter implementation
+std::unique_ptr<TokenWriter> HtmlExporter::createWriter(OutputSink& sink) const {
+    return std::make_unique<HtmlTokenWriter>(sink, fields, includeStyles, includeTokenDetails);
 }
 
 // Helper method to escape HTML special characters
-std::string HtmlExporter::escapeHtml(const std::string& input) const {
-    std::stringstream ss;
-    
-    for (char c : input) {
-        switch (c) {
-            case '&': ss << "&amp;"; break;
-            case '<': ss << "&lt;"; break;
-            case '>': ss << "&gt;"; break;
-            case '\"': ss << "&quot;"; break;
-            case '\'': ss << "&#39;"; break;
-            case '\n': ss << "<br>"; break;
-            case '\t': ss << "&nbsp;&nbsp;&nbsp;&nbsp;"; break;
-            case ' ': ss << "&nbsp;"; break;
-            default: ss << c; break;
-        }
-    }
-    
-    return ss.str();
+std::string HtmlExporter::escapeHtml(const std::string& input) {
+    return Escape::escape(input, Escape::Format::HTML);
 }
 
 // Exporter Factory implementation
-std::unique_ptr<TokenExporter> ExporterFactory::createExporter(Format format) {
+std::unique_ptr<TokenExporter> ExporterFactory::createExporter(Format format, ExportFields fields) {
+    std::unique_ptr<TokenExporter> exporter;
     switch (format) {
         case Format::JSON:
-            return std::make_unique<JsonExporter>();
+            exporter = std::make_unique<JsonExporter>();
+            break;
         case Format::XML:
-            return std::make_unique<XmlExporter>();
+            exporter = std::make_unique<XmlExporter>();
+            break;
         case Format::CSV:
-            return std::make_unique<CsvExporter>();
+            exporter = std::make_unique<CsvExporter>();
+            break;
         case Format::HTML:
-            return std::make_unique<HtmlExporter>();
+            exporter = std::make_unique<HtmlExporter>();
+            break;
+        case Format::HTML_PAGES:
+            exporter = std::make_unique<HtmlPagesExporter>();
+            break;
+        case Format::BINARY:
+            exporter = std::make_unique<BinaryExporter>();
+            break;
+        case Format::JSON_COLUMNAR:
+            exporter = std::make_unique<ColumnarJsonExporter>();
+            break;
+        case Format::NDJSON:
+            exporter = std::make_unique<NdjsonExporter>();
+            break;
+        case Format::NDJSON_FILES:
+            exporter = std::make_unique<NdjsonExporter>(true);
+            break;
         default:
             return nullptr;
     }
-} 
\ No newline at end of file
+    exporter->setFields(fields);
+    return exporter;
+}
+
+bool ExporterFactory::parseFormat(const std::string& name, Format& format) {
+    if (name == "json") {
+        format = Format::JSON;
+    } else if (name == "json-columnar" || name == "columnar") {
+        format = Format::JSON_COLUMNAR;
+    } else if (name == "xml") {
+        format = Format::XML;
+    } else if (name == "csv") {
+        format = Format::CSV;
+    } else if (name == "html") {
+        format = Format::HTML;
+    } else if (name == "html-pages") {
+        format = Format::HTML_PAGES;
+    } else if (name == "binary" || name == "bin") {
+        format = Format::BINARY;
+    } else if (name == "ndjson" || name == "jsonl") {
+        format = Format::NDJSON;
+    } else if (name == "ndjson-files") {
+        format = Format::NDJSON_FILES;
+    } else {
+        return false;
+    }
+    return true;
+}
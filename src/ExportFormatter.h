@@ -4,41 +4,150 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <fstream>
 #include "Token.h"
+#include "OutputSink.h"
+
+class ThreadPool;
+
+// Set of token fields included in an export. Unselected fields are never
+// formatted (or, for attributes, even converted to text).
+using ExportFields = unsigned;
+
+namespace ExportField {
+    constexpr ExportFields TYPE = 1u << 0;
+    constexpr ExportFields LEXEME = 1u << 1;
+    constexpr ExportFields LINE = 1u << 2;
+    constexpr ExportFields COLUMN = 1u << 3;
+    constexpr ExportFields FILENAME = 1u << 4;
+    constexpr ExportFields ATTRIBUTES = 1u << 5;
+    constexpr ExportFields ALL = TYPE | LEXEME | LINE | COLUMN | FILENAME | ATTRIBUTES;
+
+    // Parse a comma-separated list such as "type,lexeme,line"; false on an
+    // unknown or empty name
+    bool parse(const std::string& list, ExportFields& fields);
+}
+
+// Incremental token writer produced by an exporter. Tokens are formatted
+// as they arrive and go straight to the sink: call begin() once, write()
+// for every token and finish() to emit the footer and flush.
+class TokenWriter {
+private:
+    std::unique_ptr<OutputSink> ownedSink;
+
+protected:
+    OutputSink& sink;
+    ExportFields fields;
+    size_t tokenCount;
+    bool failed; // Set by writers that also write outside the sink (e.g. extra files)
+
+    virtual void writeHeader() {}
+    virtual void writeToken(const Token& token) = 0;
+    virtual void writeFooter() {}
+
+public:
+    explicit TokenWriter(OutputSink& sink, ExportFields fields = ExportField::ALL)
+        : sink(sink), fields(fields), tokenCount(0), failed(false) {}
+    virtual ~TokenWriter() = default;
+
+    void begin() { writeHeader(); }
+    void write(const Token& token) {
+        writeToken(token);
+        ++tokenCount;
+    }
+    bool finish() {
+        writeFooter();
+        return sink.flush() && !failed;
+    }
+
+    // Continue a token sequence at the given index, so a slice of a larger
+    // export is formatted exactly as it would be in a serial run. Used with
+    // write() alone for middle chunks, or before finish() for the footer.
+    void resumeAt(size_t index) { tokenCount = index; }
+
+    // Take ownership of the sink this writer formats into
+    void adoptSink(std::unique_ptr<OutputSink> owned) { ownedSink = std::move(owned); }
+
+    size_t getTokenCount() const { return tokenCount; }
+    bool good() const { return sink.good() && !failed; }
+};
 
 // Base class for token export formatters
 class TokenExporter {
+protected:
+    ExportFields fields = ExportField::ALL;
+
 public:
     virtual ~TokenExporter() = default;
-    
+
+    // Restrict exports to a subset of token fields (all by default)
+    void setFields(ExportFields selected) { fields = selected; }
+    ExportFields getFields() const { return fields; }
+
+    // Create a streaming writer that formats into the given sink
+    virtual std::unique_ptr<TokenWriter> createWriter(OutputSink& sink) const = 0;
+
+    // Create a streaming writer on a file ("-" is standard output); returns
+    // nullptr if the file can't be opened
+    virtual std::unique_ptr<TokenWriter> openFile(const std::string& filename) const;
+
     // Export tokens to string
-    virtual std::string exportToString(const std::vector<Token>& tokens) const = 0;
-    
+    virtual std::string exportToString(const std::vector<Token>& tokens) const;
+
     // Export tokens to file
-    virtual bool exportToFile(const std::vector<Token>& tokens, const std::string& filename) const {
-        std::string content = exportToString(tokens);
-        std::ofstream file(filename);
-        if (!file.is_open()) {
-            return false;
-        }
-        file << content;
-        return file.good();
-    }
+    virtual bool exportToFile(const std::vector<Token>& tokens, const std::string& filename) const;
+
+    // True if the writer keeps no state between tokens beyond the token
+    // index, so disjoint ranges can be formatted independently
+    virtual bool supportsChunkedExport() const { return false; }
+
+    // Format chunks of tokens on the pool and write them in order (pwrite
+    // at precomputed offsets for regular files). Falls back to exportToFile
+    // for exporters without chunk support or a single-threaded pool.
+    bool exportToFileParallel(const std::vector<Token>& tokens, const std::string& filename,
+                              ThreadPool& pool) const;
 };
 
 // JSON exporter
 class JsonExporter : public TokenExporter {
 public:
-    std::string exportToString(const std::vector<Token>& tokens) const override;
+    static std::string escapeJson(const std::string& input);
+
+    std::unique_ptr<TokenWriter> createWriter(OutputSink& sink) const override;
+    bool supportsChunkedExport() const override { return true; }
+};
+
+// Columnar JSON exporter: parallel arrays per field instead of one object
+// per token. Types, lexemes, filenames and attributes are stored once in
+// tables and referenced by index (-1 for a token without attributes):
+//
+//   {"layout": "columnar", "count": 3,
+//    "typeTable": ["KEYWORD", "IDENTIFIER"], "type": [0,1,1],
+//    "lexemeTable": ["int", "x"], "lexeme": [0,1,1], "line": [...], ...}
+class ColumnarJsonExporter : public TokenExporter {
+public:
+    std::unique_ptr<TokenWriter> createWriter(OutputSink& sink) const override;
+};
+
+// Newline-delimited JSON exporter: one self-contained object per token, or
+// one object per source file ({"filename": ..., "tokens": [...]}) when
+// grouping by file. Every line can be consumed as soon as it is written.
+class NdjsonExporter : public TokenExporter {
+private:
+    bool groupByFile;
+public:
+    NdjsonExporter(bool groupByFile = false) : groupByFile(groupByFile) {}
+
+    std::unique_ptr<TokenWriter> createWriter(OutputSink& sink) const override;
+    bool supportsChunkedExport() const override { return !groupByFile; }
 };
 
 // XML exporter
 class XmlExporter : public TokenExporter {
-private:
-    std::string escapeXml(const std::string& input) const;
 public:
-    std::string exportToString(const std::vector<Token>& tokens) const override;
+    static std::string escapeXml(const std::string& input);
+
+    std::unique_ptr<TokenWriter> createWriter(OutputSink& sink) const override;
+    bool supportsChunkedExport() const override { return true; }
 };
 
 // CSV exporter
@@ -46,12 +155,14 @@ class CsvExporter : public TokenExporter {
 private:
     bool includeHeaders;
     char delimiter;
-    std::string escapeCsv(const std::string& input) const;
 public:
     CsvExporter(bool includeHeaders = true, char delimiter = ',')
         : includeHeaders(includeHeaders), delimiter(delimiter) {}
-        
-    std::string exportToString(const std::vector<Token>& tokens) const override;
+
+    static std::string escapeCsv(const std::string& input);
+
+    std::unique_ptr<TokenWriter> createWriter(OutputSink& sink) const override;
+    bool supportsChunkedExport() const override { return true; }
 };
 
 // HTML exporter for visual representation
@@ -59,12 +170,13 @@ class HtmlExporter : public TokenExporter {
 private:
     bool includeStyles;
     bool includeTokenDetails;
-    std::string escapeHtml(const std::string& input) const;
 public:
     HtmlExporter(bool includeStyles = true, bool includeTokenDetails = true)
         : includeStyles(includeStyles), includeTokenDetails(includeTokenDetails) {}
-        
-    std::string exportToString(const std::vector<Token>& tokens) const override;
+
+    static std::string escapeHtml(const std::string& input);
+
+    std::unique_ptr<TokenWriter> createWriter(OutputSink& sink) const override;
 };
 
 // Factory class to create exporters
@@ -74,10 +186,18 @@ public:
         JSON,
         XML,
         CSV,
-        HTML
+        HTML,
+        HTML_PAGES,
+        BINARY,
+        JSON_COLUMNAR,
+        NDJSON,
+        NDJSON_FILES
     };
-    
-    static std::unique_ptr<TokenExporter> createExporter(Format format);
+
+    static std::unique_ptr<TokenExporter> createExporter(Format format, ExportFields fields = ExportField::ALL);
+
+    // Map a format name ("json", "xml", ...) to a Format; false if unknown
+    static bool parseFormat(const std::string& name, Format& format);
 };
 
-#endif // EXPORT_FORMATTER_H 
\ No newline at end of file
+#endif // EXPORT_FORMATTER_H
@@ -0,0 +1,258 @@
+#include "Extractor.h"
+#include <algorithm>
+#include <cctype>
+#include <memory>
+
+namespace {
+
+bool isIdentifierByte(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+} // namespace
+
+bool Extractor::parseKinds(const std::string& list, Kinds& kinds) {
+    Kinds parsed = 0;
+    size_t start = 0;
+
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        std::string name = list.substr(start, end - start);
+
+        if (name == "comments") {
+            parsed |= COMMENTS;
+        } else if (name == "docs") {
+            parsed |= DOC_COMMENTS;
+        } else if (name == "strings") {
+            parsed |= STRINGS;
+        } else if (name == "all") {
+            parsed |= ALL;
+        } else {
+            return false;
+        }
+        start = end + 1;
+    }
+
+    kinds = parsed;
+    return parsed != 0;
+}
+
+Extractor::Extractor(const LanguageConfig& config, Kinds kinds)
+    : kinds(kinds), rawPrefix(config.stringConfig.rawStringPrefix),
+      escapeChar(config.stringConfig.escapeChar != '\0' ? config.stringConfig.escapeChar : '\\'),
+      directives(true) {
+    const CommentConfig& comments = config.commentConfig;
+    const StringConfig& strings = config.stringConfig;
+
+    // Block forms come first so they win ties against line forms
+    for (const auto& delimiter : comments.multiLineCommentDelimiters) {
+        openers.push_back({delimiter.first, delimiter.second, SpanType::BLOCK_COMMENT, ByteSet()});
+    }
+    for (const auto& delimiter : comments.docCommentDelimiters) {
+        openers.push_back({delimiter.first, delimiter.second, SpanType::DOC_BLOCK_COMMENT, ByteSet()});
+    }
+    for (const auto& start : comments.singleLineCommentStarts) {
+        openers.push_back({start, "\n", SpanType::LINE_COMMENT, ByteSet()});
+    }
+    for (const auto& start : comments.docCommentStarts) {
+        openers.push_back({start, "\n", SpanType::DOC_LINE_COMMENT, ByteSet()});
+    }
+    for (const auto& delimiter : strings.stringDelimiters) {
+        openers.push_back({delimiter.first, delimiter.second, SpanType::STRING, ByteSet()});
+    }
+    for (const auto& delimiter : strings.charDelimiters) {
+        openers.push_back({delimiter.first, delimiter.second, SpanType::CHAR, ByteSet()});
+    }
+
+    openers.erase(std::remove_if(openers.begin(), openers.end(),
+                                 [](const Opener& opener) { return opener.start.empty() || opener.end.empty(); }),
+                  openers.end());
+    std::stable_sort(openers.begin(), openers.end(), [](const Opener& a, const Opener& b) {
+        return a.start.size() > b.start.size();
+    });
+
+    for (auto& opener : openers) {
+        openerBytes.add(static_cast<unsigned char>(opener.start[0]));
+        opener.stops.add(static_cast<unsigned char>(escapeChar));
+        opener.stops.add(static_cast<unsigned char>(opener.end[0]));
+    }
+    if (directives) {
+        openerBytes.add('#');
+    }
+}
+
+bool Extractor::wanted(SpanType type) const {
+    switch (type) {
+        case SpanType::LINE_COMMENT:
+        case SpanType::BLOCK_COMMENT:
+            return (kinds & COMMENTS) != 0;
+        case SpanType::DOC_LINE_COMMENT:
+        case SpanType::DOC_BLOCK_COMMENT:
+            return (kinds & (COMMENTS | DOC_COMMENTS)) != 0;
+        case SpanType::STRING:
+        case SpanType::CHAR:
+            return (kinds & STRINGS) != 0;
+    }
+    return false;
+}
+
+// A string opener directly preceded by the raw prefix (which itself is not
+// the tail of a longer identifier) starts a raw string
+bool Extractor::isRawPrefixed(std::string_view source, size_t position) const {
+    if (rawPrefix.empty() || position < rawPrefix.size()) {
+        return false;
+    }
+    size_t prefixStart = position - rawPrefix.size();
+    if (source.compare(prefixStart, rawPrefix.size(), rawPrefix) != 0) {
+        return false;
+    }
+    return prefixStart == 0 || !isIdentifierByte(source[prefixStart - 1]);
+}
+
+// Position of the closing delimiter at or after from, or npos
+size_t Extractor::findSpanEnd(std::string_view source, size_t from, const Opener& opener, bool raw,
+                              bool& escaped) const {
+    if (opener.end == "\n") {
+        size_t end = source.find('\n', from);
+        return end == std::string_view::npos ? source.size() : end;
+    }
+
+    bool isString = opener.type == SpanType::STRING || opener.type == SpanType::CHAR;
+    if (!isString || raw) {
+        return source.find(opener.end, from);
+    }
+
+    // Strings: stop at the escape character or the first byte of the end
+    // delimiter, whichever comes first
+    while (from < source.size()) {
+        size_t hit = from + findFirstOf(source.data() + from, source.size() - from, opener.stops);
+        if (hit >= source.size()) {
+            break;
+        }
+        if (source[hit] == escapeChar) {
+            escaped = true;
+            from = hit + 2;
+        } else if (source.compare(hit, opener.end.size(), opener.end) == 0) {
+            return hit;
+        } else {
+            from = hit + 1;
+        }
+    }
+    return std::string_view::npos;
+}
+
+void Extractor::walk(std::string_view source, const std::function<bool(const Span&)>& onSpan) const {
+    const size_t size = source.size();
+    size_t position = 0;
+    while (position < size) {
+        size_t hit = position + findFirstOf(source.data() + position, size - position, openerBytes);
+        if (hit >= size) {
+            break;
+        }
+
+        const Opener* opener = nullptr;
+        for (const auto& candidate : openers) {
+            if (source.compare(hit, candidate.start.size(), candidate.start) == 0) {
+                opener = &candidate;
+                break;
+            }
+        }
+
+        Span span{opener, hit, hit, hit, hit, true, false, false};
+        if (!opener) {
+            if (!directives || source[hit] != '#' || (hit > 0 && source[hit - 1] != '\n')) {
+                position = hit + 1;
+                continue;
+            }
+            size_t end = source.find('\n', hit);
+            span.bodyEnd = span.end = end == std::string_view::npos ? size : end;
+        } else {
+            span.raw = opener->type == SpanType::STRING && isRawPrefixed(source, hit);
+            span.start = span.raw ? hit - rawPrefix.size() : hit;
+            span.bodyStart = hit + opener->start.size();
+            size_t end = findSpanEnd(source, span.bodyStart, *opener, span.raw, span.escaped);
+            span.terminated = end != std::string_view::npos;
+            span.bodyEnd = span.terminated ? end : size;
+            span.end = span.terminated && opener->end != "\n" ? end + opener->end.size() : span.bodyEnd;
+        }
+
+        if (!onSpan(span)) {
+            break;
+        }
+        position = span.end;
+    }
+}
+
+void Extractor::forEachSpan(std::string_view source, const std::function<bool(size_t, size_t)>& onSpan) const {
+    walk(source, [&onSpan](const Span& span) { return onSpan(span.start, span.end); });
+}
+
+size_t Extractor::extract(std::string_view source, const std::string& filename,
+                          const std::function<void(const Token&)>& onToken) const {
+    size_t emitted = 0;
+
+    // Lines are counted lazily, only up to spans that are emitted
+    size_t counted = 0;
+    size_t line = 1;
+    size_t lineStart = 0;
+    auto locate = [&](size_t position, int& tokenLine, int& tokenColumn) {
+        size_t newlines = countByte(source.data() + counted, position - counted, '\n');
+        if (newlines > 0) {
+            line += newlines;
+            lineStart = source.rfind('\n', position - 1) + 1;
+        }
+        counted = position;
+        tokenLine = static_cast<int>(line);
+        tokenColumn = static_cast<int>(position - lineStart + 1);
+    };
+
+    walk(source, [&](const Span& span) {
+        if (!span.opener || !wanted(span.opener->type)) {
+            return true;
+        }
+
+        TokenType type = TokenType::ERROR;
+        std::shared_ptr<TokenAttribute> attribute;
+        if (span.terminated) {
+            switch (span.opener->type) {
+                case SpanType::LINE_COMMENT:
+                    type = TokenType::COMMENT;
+                    attribute = std::make_shared<CommentAttribute>(CommentAttribute::Type::SINGLE_LINE);
+                    break;
+                case SpanType::BLOCK_COMMENT:
+                    type = TokenType::COMMENT;
+                    attribute = std::make_shared<CommentAttribute>(CommentAttribute::Type::MULTI_LINE);
+                    break;
+                case SpanType::DOC_LINE_COMMENT:
+                case SpanType::DOC_BLOCK_COMMENT:
+                    type = TokenType::COMMENT;
+                    attribute = std::make_shared<CommentAttribute>(CommentAttribute::Type::DOC_COMMENT);
+                    break;
+                case SpanType::STRING:
+                case SpanType::CHAR:
+                    type = span.opener->type == SpanType::STRING ? TokenType::STRING_LITERAL
+                                                                 : TokenType::CHAR_LITERAL;
+                    if (span.raw || span.escaped) {
+                        attribute = std::make_shared<StringAttribute>(span.raw, span.escaped);
+                    }
+                    break;
+            }
+        }
+
+        int tokenLine;
+        int tokenColumn;
+        locate(span.start, tokenLine, tokenColumn);
+        Token token(type, std::string(source.substr(span.bodyStart, span.bodyEnd - span.bodyStart)),
+                    tokenLine, tokenColumn, filename);
+        token.location.offset = span.start;
+        token.attribute = std::move(attribute);
+        onToken(token);
+        emitted++;
+        return true;
+    });
+
+    return emitted;
+}
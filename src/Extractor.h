@@ -0,0 +1,97 @@
+#ifndef EXTRACTOR_H
+#define EXTRACTOR_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include "Token.h"
+#include "LanguageConfig.h"
+#include "ByteScan.h"
+
+// Pulls comments, doc comments and string literals out of source text
+// without tokenizing it. The first bytes of all comment and string
+// openers from the language's CommentConfig/StringConfig are searched
+// with findFirstOf; everything in between is skipped, and line numbers
+// are only computed (with countByte) for the spans that are emitted.
+//
+// Spans are handed out as COMMENT, STRING_LITERAL or CHAR_LITERAL tokens
+// whose lexeme is the text between the delimiters; comments carry a
+// CommentAttribute and strings a StringAttribute. Where openers overlap
+// the longest one wins, so "/**" is a doc comment and '"""' a Python
+// block string. Like the lexer, a '#' in column 1 starts a directive line
+// whose contents are not extracted, and an unterminated span is reported
+// as an ERROR token running to the end of the input.
+class Extractor {
+public:
+    enum Kind : unsigned {
+        COMMENTS = 1u << 0,
+        DOC_COMMENTS = 1u << 1,
+        STRINGS = 1u << 2,
+        ALL = COMMENTS | DOC_COMMENTS | STRINGS
+    };
+    using Kinds = unsigned;
+
+    // Parse a comma-separated list of "comments", "docs" and "strings"
+    static bool parseKinds(const std::string& list, Kinds& kinds);
+
+private:
+    enum class SpanType {
+        LINE_COMMENT,
+        BLOCK_COMMENT,
+        DOC_LINE_COMMENT,
+        DOC_BLOCK_COMMENT,
+        STRING,
+        CHAR
+    };
+
+    struct Opener {
+        std::string start;
+        std::string end;
+        SpanType type;
+        ByteSet stops; // escape character and first end byte (strings)
+    };
+
+    // A comment, string or directive line found in the source; opener is
+    // null for directives
+    struct Span {
+        const Opener* opener;
+        size_t start;
+        size_t bodyStart;
+        size_t bodyEnd;
+        size_t end;
+        bool terminated;
+        bool raw;
+        bool escaped;
+    };
+
+    Kinds kinds;
+    std::vector<Opener> openers;
+    std::string rawPrefix;
+    char escapeChar;
+    bool directives;
+    ByteSet openerBytes;
+
+    bool wanted(SpanType type) const;
+    bool isRawPrefixed(std::string_view source, size_t position) const;
+    size_t findSpanEnd(std::string_view source, size_t from, const Opener& opener, bool raw,
+                       bool& escaped) const;
+
+    // Visit every span in order until onSpan returns false
+    void walk(std::string_view source, const std::function<bool(const Span&)>& onSpan) const;
+
+public:
+    Extractor(const LanguageConfig& config, Kinds kinds = ALL);
+
+    // Call onToken for every wanted span in order; returns the number of
+    // spans emitted
+    size_t extract(std::string_view source, const std::string& filename,
+                   const std::function<void(const Token&)>& onToken) const;
+
+    // Call onSpan(begin, end) for every comment, string and directive line,
+    // whatever kinds were requested, until it returns false. Everything
+    // outside these spans is plain code.
+    void forEachSpan(std::string_view source, const std::function<bool(size_t, size_t)>& onSpan) const;
+};
+
+#endif // EXTRACTOR_H
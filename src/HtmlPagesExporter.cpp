@@ -0,0 +1,433 @@
+#include "HtmlPagesExporter.h"
+#include "ByteScan.h"
+#include "Escape.h"
+#include "MappedFile.h"
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const char STYLESHEET[] =
+    "body { font-family: Arial, sans-serif; margin: 0; }\n"
+    "nav { padding: 6px 12px; background-color: #f2f2f2; border-bottom: 1px solid #ddd; font-size: 0.9em; }\n"
+    "nav a { margin-right: 12px; }\n"
+    "h1 { font-size: 1.4em; margin: 12px; }\n"
+    "h2 { font-size: 1em; margin: 12px; }\n"
+    "pre { font-family: monospace; margin: 0; padding: 12px; line-height: 1.4; }\n"
+    ".k { color: #0000cc; font-weight: bold; }\n"
+    ".n, .nf, .nx, .no, .nb, .ne { color: #aa00aa; }\n"
+    ".s, .sc { color: #008800; }\n"
+    ".o, .oa, .om, .ol, .ob, .oc { color: #cc0000; }\n"
+    ".d, .dp, .db, .dc, .ds, .dm, .dd { color: #666666; }\n"
+    ".p { color: #009900; font-style: italic; }\n"
+    ".c { color: #999999; font-style: italic; }\n"
+    ".e, .u { color: #ff0000; background-color: #ffeeee; }\n";
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+std::string pageName(const std::string& base, size_t number) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "-%04zu.html", number);
+    return base + suffix;
+}
+
+// Streaming writer for highlighted source. Each token's text runs from its
+// offset to the next token's offset (minus trailing whitespace), so a token
+// is rendered once its successor arrives.
+class HighlightedSourceWriter : public TokenWriter {
+private:
+    struct PageEntry {
+        size_t number;
+        int firstLine;
+        int lastLine;
+    };
+
+    struct FileEntry {
+        std::string filename;
+        std::vector<PageEntry> pages;
+    };
+
+    // Paging; an empty basePath means a single document written to the sink
+    size_t pageLines;
+    std::string basePath;
+    std::string baseName;
+    std::string indexName;
+    std::unique_ptr<FileSink> page;
+    OutputSink* out;
+    size_t pageCount;
+    int pageFirstLine;
+    int currentLine;
+    bool breakPending;
+    std::vector<FileEntry> files;
+
+    // Current source file
+    bool inFile;
+    std::string currentFile;
+    MappedFile mapped;
+    const char* source;
+    size_t sourceSize;
+    size_t position;
+
+    // Token waiting for its extent
+    bool hasPending;
+    TokenType pendingType;
+    size_t pendingOffset;
+    int lastTokenLine;
+    bool atFileStart;
+
+    bool paged() const { return !basePath.empty(); }
+
+    void writeEscaped(const char* text, size_t size) {
+        Escape::write(*out, std::string_view(text, size), Escape::Format::XML);
+    }
+
+    void openPage() {
+        breakPending = false;
+        pageFirstLine = currentLine;
+        const std::string& filename = files.back().filename;
+
+        if (!paged()) {
+            out = &sink;
+            out->write("<h2>");
+            writeEscaped(filename.data(), filename.size());
+            out->write("</h2>\n<pre>");
+            return;
+        }
+
+        ++pageCount;
+        files.back().pages.push_back({pageCount, currentLine, currentLine});
+        page = std::make_unique<FileSink>(pageName(basePath, pageCount), 256 * 1024);
+        if (!page->isOpen()) {
+            failed = true;
+        }
+        out = page.get();
+
+        out->write("<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"UTF-8\">\n<title>");
+        writeEscaped(filename.data(), filename.size());
+        out->write("</title>\n<link rel=\"stylesheet\" href=\"");
+        out->write(baseName);
+        out->write(".css\">\n</head>\n<body>\n<nav><a href=\"");
+        out->write(indexName);
+        out->write("\">Index</a>");
+        if (files.back().pages.size() > 1) {
+            out->write("<a href=\"");
+            out->write(pageName(baseName, pageCount - 1));
+            out->write("\">Previous</a>");
+        }
+        writeEscaped(filename.data(), filename.size());
+        out->write(" &middot; from line ");
+        out->writeInt(currentLine);
+        out->write("</nav>\n<pre>");
+    }
+
+    void closePage(bool hasNext) {
+        out->write("</pre>\n");
+        if (!paged()) {
+            return;
+        }
+
+        PageEntry& entry = files.back().pages.back();
+        entry.lastLine = hasNext ? currentLine - 1 : currentLine;
+
+        out->write("<nav><a href=\"");
+        out->write(indexName);
+        out->write("\">Index</a>");
+        if (files.back().pages.size() > 1) {
+            out->write("<a href=\"");
+            out->write(pageName(baseName, entry.number - 1));
+            out->write("\">Previous</a>");
+        }
+        if (hasNext) {
+            out->write("<a href=\"");
+            out->write(pageName(baseName, entry.number + 1));
+            out->write("\">Next</a>");
+        }
+        out->write("lines ");
+        out->writeInt(entry.firstLine);
+        out->write("&ndash;");
+        out->writeInt(entry.lastLine);
+        out->write("</nav>\n</body>\n</html>\n");
+
+        if (!page->close()) {
+            failed = true;
+        }
+        page.reset();
+        out = &sink;
+    }
+
+    // A page break was requested at a line boundary; start the next page
+    // only once there is more content for it
+    void ensurePage() {
+        if (breakPending) {
+            closePage(true);
+            openPage();
+        }
+    }
+
+    // Whitespace (or skipped text) between tokens; pages break at newlines
+    void emitGap(const char* text, size_t size) {
+        while (size > 0) {
+            ensurePage();
+            const char* newline = static_cast<const char*>(std::memchr(text, '\n', size));
+            size_t run = newline ? static_cast<size_t>(newline - text) + 1 : size;
+            writeEscaped(text, run);
+            text += run;
+            size -= run;
+
+            if (newline) {
+                ++currentLine;
+                if (paged() && static_cast<size_t>(currentLine - pageFirstLine) >= pageLines) {
+                    breakPending = true;
+                }
+            }
+        }
+    }
+
+    // Token text never splits across pages
+    void emitSpan(TokenType type, const char* text, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        ensurePage();
+        out->write("<span class=\"");
+        out->write(HtmlPagesExporter::cssClass(type));
+        out->write("\">");
+        writeEscaped(text, size);
+        out->write("</span>");
+        currentLine += static_cast<int>(countByte(text, size, '\n'));
+    }
+
+    // Render the pending token up to end and the whitespace after it
+    void flushPending(size_t end) {
+        if (!hasPending) {
+            return;
+        }
+        hasPending = false;
+
+        size_t tokenEnd = end;
+        while (tokenEnd > pendingOffset && isSpace(source[tokenEnd - 1])) {
+            --tokenEnd;
+        }
+        emitSpan(pendingType, source + pendingOffset, tokenEnd - pendingOffset);
+        position = tokenEnd;
+    }
+
+    void startFile(const std::string& filename) {
+        inFile = true;
+        currentFile = filename;
+        files.push_back({filename, {}});
+
+        mapped.close();
+        if (!filename.empty() && mapped.open(filename)) {
+            source = reinterpret_cast<const char*>(mapped.bytes());
+            sourceSize = mapped.size();
+        } else {
+            source = nullptr;
+            sourceSize = 0;
+        }
+
+        position = 0;
+        hasPending = false;
+        currentLine = 1;
+        lastTokenLine = 1;
+        atFileStart = true;
+        openPage();
+    }
+
+    void finishFile() {
+        if (!inFile) {
+            return;
+        }
+        inFile = false;
+
+        if (source) {
+            flushPending(sourceSize);
+            emitGap(source + position, sourceSize - position);
+        }
+        breakPending = false;
+        closePage(false);
+        mapped.close();
+        source = nullptr;
+    }
+
+    // Without the source text, lay out lexemes by their line numbers
+    void writeFromLexeme(const Token& token) {
+        if (token.location.line > lastTokenLine) {
+            for (int line = lastTokenLine; line < token.location.line; ++line) {
+                emitGap("\n", 1);
+            }
+        } else if (!atFileStart) {
+            emitGap(" ", 1);
+        }
+        atFileStart = false;
+        lastTokenLine = token.location.line;
+        emitSpan(token.type, token.lexeme.data(), token.lexeme.size());
+    }
+
+    void writeStylesheet() {
+        FileSink css(basePath + ".css", 16 * 1024);
+        if (!css.isOpen()) {
+            failed = true;
+            return;
+        }
+        css.write(STYLESHEET, sizeof(STYLESHEET) - 1);
+        if (!css.close()) {
+            failed = true;
+        }
+    }
+
+    void writeIndex() {
+        sink.write("<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"UTF-8\">\n");
+        sink.write("<title>Token Visualization</title>\n<link rel=\"stylesheet\" href=\"");
+        sink.write(baseName);
+        sink.write(".css\">\n</head>\n<body>\n<h1>Token Visualization</h1>\n<ul>\n");
+
+        for (const auto& file : files) {
+            sink.write("  <li>");
+            Escape::write(sink, file.filename, Escape::Format::XML);
+            for (const auto& entry : file.pages) {
+                sink.write(" <a href=\"");
+                sink.write(pageName(baseName, entry.number));
+                sink.write("\">");
+                sink.writeInt(entry.firstLine);
+                sink.write("&ndash;");
+                sink.writeInt(entry.lastLine);
+                sink.write("</a>");
+            }
+            sink.write("</li>\n");
+        }
+
+        sink.write("</ul>\n</body>\n</html>\n");
+    }
+
+public:
+    HighlightedSourceWriter(OutputSink& sink, size_t pageLines, const std::string& indexPath,
+                            const std::string& basePath)
+        : TokenWriter(sink), pageLines(pageLines), basePath(basePath), out(&sink), pageCount(0),
+          pageFirstLine(1), currentLine(1), breakPending(false), inFile(false), source(nullptr),
+          sourceSize(0), position(0), hasPending(false), pendingType(TokenType::UNKNOWN),
+          pendingOffset(0), lastTokenLine(1), atFileStart(true) {
+        // Pages link to each other by name, relative to the index
+        size_t slash = basePath.find_last_of('/');
+        baseName = slash == std::string::npos ? basePath : basePath.substr(slash + 1);
+        slash = indexPath.find_last_of('/');
+        indexName = slash == std::string::npos ? indexPath : indexPath.substr(slash + 1);
+    }
+
+protected:
+    void writeHeader() override {
+        if (paged()) {
+            writeStylesheet();
+            return;
+        }
+
+        sink.write("<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"UTF-8\">\n");
+        sink.write("<title>Token Visualization</title>\n<style>\n");
+        sink.write(STYLESHEET, sizeof(STYLESHEET) - 1);
+        sink.write("</style>\n</head>\n<body>\n");
+    }
+
+    void writeToken(const Token& token) override {
+        if (!inFile || token.location.filename != currentFile) {
+            finishFile();
+            startFile(token.location.filename);
+        }
+
+        if (token.type == TokenType::EOF_TOKEN) {
+            finishFile();
+            return;
+        }
+
+        if (!source) {
+            writeFromLexeme(token);
+            return;
+        }
+
+        size_t offset = token.location.offset;
+        if (offset < position || offset > sourceSize) {
+            offset = position;
+        }
+        flushPending(offset);
+        emitGap(source + position, offset - position);
+        position = offset;
+
+        hasPending = true;
+        pendingType = token.type;
+        pendingOffset = offset;
+    }
+
+    void writeFooter() override {
+        finishFile();
+        if (paged()) {
+            writeIndex();
+        } else {
+            sink.write("</body>\n</html>\n");
+        }
+    }
+};
+
+} // namespace
+
+const char* HtmlPagesExporter::cssClass(TokenType type) {
+    switch (type) {
+        case TokenType::INTEGER: return "n";
+        case TokenType::FLOAT: return "nf";
+        case TokenType::HEX: return "nx";
+        case TokenType::OCTAL: return "no";
+        case TokenType::BINARY: return "nb";
+        case TokenType::SCIENTIFIC: return "ne";
+        case TokenType::STRING_LITERAL: return "s";
+        case TokenType::CHAR_LITERAL: return "sc";
+        case TokenType::IDENTIFIER: return "i";
+        case TokenType::KEYWORD: return "k";
+        case TokenType::OPERATOR: return "o";
+        case TokenType::ASSIGNMENT_OPERATOR: return "oa";
+        case TokenType::ARITHMETIC_OPERATOR: return "om";
+        case TokenType::LOGICAL_OPERATOR: return "ol";
+        case TokenType::BITWISE_OPERATOR: return "ob";
+        case TokenType::COMPARISON_OPERATOR: return "oc";
+        case TokenType::DELIMITER: return "d";
+        case TokenType::PARENTHESIS: return "dp";
+        case TokenType::BRACKET: return "db";
+        case TokenType::BRACE: return "dc";
+        case TokenType::SEMICOLON: return "ds";
+        case TokenType::COMMA: return "dm";
+        case TokenType::DOT: return "dd";
+        case TokenType::PREPROCESSOR: return "p";
+        case TokenType::COMMENT: return "c";
+        case TokenType::ERROR: return "e";
+        default: return "u";
+    }
+}
+
+std::unique_ptr<TokenWriter> HtmlPagesExporter::createWriter(OutputSink& sink) const {
+    return std::make_unique<HighlightedSourceWriter>(sink, pageLines, std::string(), std::string());
+}
+
+std::unique_ptr<TokenWriter> HtmlPagesExporter::openFile(const std::string& filename) const {
+    if (filename == "-") {
+        return TokenExporter::openFile(filename);
+    }
+
+    auto sink = std::make_unique<FileSink>(filename);
+    if (!sink->isOpen()) {
+        return nullptr;
+    }
+
+    // Pages and the stylesheet are named after the index file
+    std::string basePath = filename;
+    for (const char* extension : {".html", ".htm"}) {
+        size_t length = std::strlen(extension);
+        if (basePath.size() > length && basePath.compare(basePath.size() - length, length, extension) == 0) {
+            basePath.erase(basePath.size() - length);
+            break;
+        }
+    }
+
+    auto writer = std::make_unique<HighlightedSourceWriter>(*sink, pageLines, filename, basePath);
+    writer->adoptSink(std::move(sink));
+    return writer;
+}
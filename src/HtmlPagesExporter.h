@@ -0,0 +1,40 @@
+#ifndef HTML_PAGES_EXPORTER_H
+#define HTML_PAGES_EXPORTER_H
+
+#include <string>
+#include <memory>
+#include "Token.h"
+#include "ExportFormatter.h"
+
+// Highlighted-source HTML for large inputs. Instead of a table row per
+// token, the source text itself is rendered with one <span> per token
+// (one short class per TokenType) and split into pages of a fixed number
+// of lines. Exporting to out.html writes:
+//
+//   out.html            index of files and their pages
+//   out.css             shared stylesheet
+//   out-0001.html ...   pages, written as the tokens arrive
+//
+// The source is read from each token's filename. Writing to a sink or to
+// stdout produces a single unpaginated document with inline styles.
+class HtmlPagesExporter : public TokenExporter {
+private:
+    size_t pageLines;
+
+public:
+    static constexpr size_t DEFAULT_PAGE_LINES = 1000;
+
+    HtmlPagesExporter(size_t pageLines = DEFAULT_PAGE_LINES)
+        : pageLines(pageLines > 0 ? pageLines : DEFAULT_PAGE_LINES) {}
+
+    void setPageLines(size_t lines) { pageLines = lines > 0 ? lines : DEFAULT_PAGE_LINES; }
+    size_t getPageLines() const { return pageLines; }
+
+    // Short CSS class used for a token type ("k" for keywords, ...)
+    static const char* cssClass(TokenType type);
+
+    std::unique_ptr<TokenWriter> createWriter(OutputSink& sink) const override;
+    std::unique_ptr<TokenWriter> openFile(const std::string& filename) const override;
+};
+
+#endif // HTML_PAGES_EXPORTER_H
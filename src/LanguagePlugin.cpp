@@ -41,7 +41,7 @@ void LanguagePluginManager::scanForPlugins() {
         for (const auto& entry : std::filesystem::directory_iterator(pluginsDirectory)) {
             if (entry.is_regular_file() && entry.path().extension() == ".json") {
                 std::string filename = entry.path().filename().string();
-                std::cout << "Found config file: " << filename << std::endl;
+                std::clog << "Found config file: " << filename << std::endl;
                 
                 // Try to load the language definition to get its name
                 try {
@@ -63,23 +63,23 @@ void LanguagePluginManager::scanForPlugins() {
                         // Only register if different from name
                         if (fileBaseName != lowerName) {
                             registerPlugin(fileBaseName, entry.path().string());
-                            std::cout << "  - Also registered as: " << fileBaseName << std::endl;
+                            std::clog << "  - Also registered as: " << fileBaseName << std::endl;
                         }
                         
                         // Register common language aliases
                         if (fileBaseName == "cpp") {
                             registerPlugin("c++", entry.path().string());
-                            std::cout << "  - Also registered as: c++" << std::endl;
+                            std::clog << "  - Also registered as: c++" << std::endl;
                         } else if (fileBaseName == "js") {
                             registerPlugin("javascript", entry.path().string());
-                            std::cout << "  - Also registered as: javascript" << std::endl;
+                            std::clog << "  - Also registered as: javascript" << std::endl;
                         } else if (fileBaseName == "python") {
                             registerPlugin("py", entry.path().string());
-                            std::cout << "  - Also registered as: py" << std::endl;
+                            std::clog << "  - Also registered as: py" << std::endl;
                         }
                     }
                     
-                    std::cout << "Found language plugin: " << name << " (" << filename << ")" << std::endl;
+                    std::clog << "Found language plugin: " << name << " (" << filename << ")" << std::endl;
                 } catch (const std::exception& e) {
                     std::cerr << "Error loading language plugin " << filename << ": " << e.what() << std::endl;
                 }
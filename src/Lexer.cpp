@@ -1,4 +1,5 @@
 #include "Lexer.h"
+#include "ByteScan.h"
 #include <cctype>
 #include <sstream>
 #include <iostream>
@@ -7,33 +8,50 @@
 #include <memory>
 #include <string>
 
+namespace {
+
+// Returned when reading past the end of a token stream
+const Token& endOfStream() {
+    static const Token eofToken(TokenType::EOF_TOKEN, "", 0, 0);
+    return eofToken;
+}
+
+} // namespace
+
 // TokenStream implementation
-TokenStream::TokenStream(const std::vector<Token>& tokens) 
-    : tokens(tokens), position(0) {}
+TokenStream::TokenStream(const std::vector<Token>& tokens, bool buildIndex)
+    : tokens(tokens), position(0), indexed(false) {
+    if (buildIndex) {
+        this->buildIndex();
+    }
+}
+
+TokenStream::TokenStream(std::vector<Token>&& tokens, bool buildIndex)
+    : tokens(std::move(tokens)), position(0), indexed(false) {
+    if (buildIndex) {
+        this->buildIndex();
+    }
+}
 
-Token TokenStream::current() const {
+const Token& TokenStream::current() const {
     if (position < tokens.size()) {
         return tokens[position];
     }
-    // Return EOF token if at the end
-    static Token eofToken(TokenType::EOF_TOKEN, "", 0, 0);
-    return eofToken;
+    return endOfStream();
 }
 
-Token TokenStream::next() {
-    Token token = current();
+const Token& TokenStream::next() {
+    const Token& token = current();
     advance();
     return token;
 }
 
-Token TokenStream::peek(int offset) const {
+const Token& TokenStream::peek(int offset) const {
     size_t peekPos = position + offset;
     if (peekPos < tokens.size()) {
         return tokens[peekPos];
     }
-    // Return EOF token if beyond the end
-    static Token eofToken(TokenType::EOF_TOKEN, "", 0, 0);
-    return eofToken;
+    return endOfStream();
 }
 
 bool TokenStream::hasMore() const {
@@ -51,6 +69,10 @@ void TokenStream::reset() {
     position = 0;
 }
 
+void TokenStream::seek(size_t index) {
+    position = std::min(index, tokens.size());
+}
+
 std::vector<Token> TokenStream::getContext(int before, int after) const {
     std::vector<Token> context;
     
@@ -71,15 +93,95 @@ void TokenStream::advance(int count) {
 }
 
 void TokenStream::skipUntil(TokenType type) {
-    while (hasMore() && current().type != type) {
-        advance();
-    }
+    position = nextOccurrence(type, position);
 }
 
 void TokenStream::skipUntil(const std::string& lexeme) {
-    while (hasMore() && current().lexeme != lexeme) {
-        advance();
+    position = nextOccurrence(lexeme, position);
+}
+
+void TokenStream::buildIndex() {
+    typePositions.assign(static_cast<size_t>(TokenType::UNKNOWN) + 1, {});
+    lexemePositions.clear();
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        typePositions[static_cast<size_t>(tokens[i].type)].push_back(i);
+        lexemePositions[tokens[i].lexeme].push_back(i);
+    }
+    indexed = true;
+}
+
+const std::vector<size_t>* TokenStream::positionsOf(TokenType type) const {
+    size_t slot = static_cast<size_t>(type);
+    return slot < typePositions.size() ? &typePositions[slot] : nullptr;
+}
+
+const std::vector<size_t>* TokenStream::positionsOf(const std::string& lexeme) const {
+    auto it = lexemePositions.find(lexeme);
+    return it != lexemePositions.end() ? &it->second : nullptr;
+}
+
+size_t TokenStream::nextOccurrence(TokenType type, size_t from) const {
+    if (indexed) {
+        const std::vector<size_t>* positions = positionsOf(type);
+        if (!positions) {
+            return tokens.size();
+        }
+        auto it = std::lower_bound(positions->begin(), positions->end(), from);
+        return it != positions->end() ? *it : tokens.size();
+    }
+    while (from < tokens.size() && tokens[from].type != type) {
+        ++from;
     }
+    return std::min(from, tokens.size());
+}
+
+size_t TokenStream::nextOccurrence(const std::string& lexeme, size_t from) const {
+    if (indexed) {
+        const std::vector<size_t>* positions = positionsOf(lexeme);
+        if (!positions) {
+            return tokens.size();
+        }
+        auto it = std::lower_bound(positions->begin(), positions->end(), from);
+        return it != positions->end() ? *it : tokens.size();
+    }
+    while (from < tokens.size() && tokens[from].lexeme != lexeme) {
+        ++from;
+    }
+    return std::min(from, tokens.size());
+}
+
+size_t TokenStream::countInRange(TokenType type, size_t begin, size_t end) const {
+    end = std::min(end, tokens.size());
+    if (begin >= end) {
+        return 0;
+    }
+    if (indexed) {
+        const std::vector<size_t>* positions = positionsOf(type);
+        if (!positions) {
+            return 0;
+        }
+        return std::lower_bound(positions->begin(), positions->end(), end) -
+               std::lower_bound(positions->begin(), positions->end(), begin);
+    }
+    return std::count_if(tokens.begin() + begin, tokens.begin() + end,
+                         [type](const Token& token) { return token.type == type; });
+}
+
+size_t TokenStream::countInRange(const std::string& lexeme, size_t begin, size_t end) const {
+    end = std::min(end, tokens.size());
+    if (begin >= end) {
+        return 0;
+    }
+    if (indexed) {
+        const std::vector<size_t>* positions = positionsOf(lexeme);
+        if (!positions) {
+            return 0;
+        }
+        return std::lower_bound(positions->begin(), positions->end(), end) -
+               std::lower_bound(positions->begin(), positions->end(), begin);
+    }
+    return std::count_if(tokens.begin() + begin, tokens.begin() + end,
+                         [&lexeme](const Token& token) { return token.lexeme == lexeme; });
 }
 
 bool TokenStream::lookingAt(TokenType type) const {
@@ -96,7 +198,7 @@ bool TokenStream::lookingAtSequence(const std::vector<TokenType>& types) const {
     }
     
     for (size_t i = 0; i < types.size(); ++i) {
-        if (peek(i).type != types[i]) {
+        if (tokens[position + i].type != types[i]) {
             return false;
         }
     }
@@ -110,7 +212,7 @@ bool TokenStream::lookingAtSequence(const std::vector<std::string>& lexemes) con
     }
     
     for (size_t i = 0; i < lexemes.size(); ++i) {
-        if (peek(i).lexeme != lexemes[i]) {
+        if (tokens[position + i].lexeme != lexemes[i]) {
             return false;
         }
     }
@@ -118,11 +220,23 @@ bool TokenStream::lookingAtSequence(const std::vector<std::string>& lexemes) con
     return true;
 }
 
+std::vector<QueryMatch> TokenStream::findAll(const TokenQuery& query) const {
+    std::vector<QueryMatch> matches;
+    TokenQuery::Matcher matcher(query);
+    QueryMatch match;
+    for (size_t i = position; i < tokens.size(); ++i) {
+        if (matcher.feed(tokens[i], match)) {
+            matches.push_back({match.first + position, match.last + position});
+        }
+    }
+    return matches;
+}
+
 // Lexer implementation
 Lexer::Lexer(const std::string& source, const std::string& filename)
     : source(source), filename(filename), position(0), line(1), column(1),
       processPreprocessorDirectives(true), isDocComment(false), 
-      isRawString(false), hasEscapeSequences(false) {
+      isRawString(false), hasEscapeSequences(false), trackBrackets(false), symbolMode(SymbolMode::INLINE) {
     
     // Initialize with default C++ config
     config = LanguageConfig::createCppConfig();
@@ -140,7 +254,7 @@ Lexer::Lexer(const std::string& source, const std::string& filename)
 Lexer::Lexer(const std::string& source, const LanguageConfig& config, const std::string& filename)
     : source(source), filename(filename), position(0), line(1), column(1), config(config),
       processPreprocessorDirectives(true), isDocComment(false), 
-      isRawString(false), hasEscapeSequences(false) {
+      isRawString(false), hasEscapeSequences(false), trackBrackets(false), symbolMode(SymbolMode::INLINE) {
     
     // Initialize the symbol table
     symbolTable = std::make_shared<SymbolTable>();
@@ -164,10 +278,35 @@ void Lexer::addIncludePath(const std::string& path) {
     includePaths.push_back(path);
 }
 
+void Lexer::setTokenFilter(const TokenFilter& tokenFilter) {
+    filter = tokenFilter;
+}
+
+const TokenFilter& Lexer::getTokenFilter() const {
+    return filter;
+}
+
+void Lexer::setBracketTracking(bool enabled) {
+    trackBrackets = enabled;
+    brackets.clear();
+}
+
+const BracketIndex& Lexer::getBracketIndex() const {
+    return brackets;
+}
+
 void Lexer::setSymbolTable(std::shared_ptr<SymbolTable> table) {
     symbolTable = table;
 }
 
+void Lexer::setSymbolMode(SymbolMode mode) {
+    symbolMode = mode;
+}
+
+SymbolMode Lexer::getSymbolMode() const {
+    return symbolMode;
+}
+
 std::shared_ptr<SymbolTable> Lexer::getSymbolTable() const {
     return symbolTable;
 }
@@ -185,6 +324,24 @@ void Lexer::advance() {
     currentChar = position < source.length() ? source[position] : '\0';
 }
 
+void Lexer::advanceTo(size_t target) {
+    target = std::min(target, source.length());
+    if (target <= position) {
+        return;
+    }
+    
+    size_t newlines = countByte(source.data() + position, target - position, '\n');
+    if (newlines > 0) {
+        line += newlines;
+        column = target - source.rfind('\n', target - 1);
+    } else {
+        column += target - position;
+    }
+    
+    position = target;
+    currentChar = position < source.length() ? source[position] : '\0';
+}
+
 void Lexer::skipWhitespace() {
     while (currentChar != '\0' && std::isspace(currentChar)) {
         advance();
@@ -347,6 +504,76 @@ bool Lexer::isStartOfString(std::string& startDelimiter, std::string& endDelimit
 
 // Main token processing
 Token Lexer::getNextToken() {
+    for (;;) {
+        if (stateStack.top() == LexerState::NORMAL) {
+            skipWhitespace();
+            if (skipFilteredToken()) {
+                continue;
+            }
+        }
+        
+        // Remember where the token starts in the source
+        size_t tokenStart = position;
+        Token token = scanToken();
+        token.location.offset = tokenStart;
+        if (tracksSymbolsInline()) {
+            SymbolTableBuilder::trackScope(*symbolTable, token);
+        }
+        if (filter.accepts(token)) {
+            if (trackBrackets) {
+                brackets.add(token);
+            }
+            return token;
+        }
+    }
+}
+
+bool Lexer::skipFilteredToken() {
+    bool dropComments = filter.drops(TokenType::COMMENT);
+    bool dropDirectives = filter.drops(TokenType::PREPROCESSOR);
+    if (currentChar == '\0' || (!dropComments && !dropDirectives)) {
+        return false;
+    }
+    
+    // Comments take precedence over directives, as in scanToken
+    std::string commentStart, commentEnd;
+    bool isDoc;
+    if (isStartOfComment(commentStart, commentEnd, isDoc)) {
+        if (!dropComments) {
+            return false;
+        }
+        
+        size_t bodyStart = position + commentStart.length();
+        if (commentEnd == "\n") {
+            advanceTo(source.find('\n', bodyStart));
+            return true;
+        }
+        
+        // Unterminated comments are scanned normally to report the error
+        size_t end = source.find(commentEnd, bodyStart);
+        if (end == std::string::npos) {
+            return false;
+        }
+        advanceTo(end + commentEnd.length());
+        return true;
+    }
+    
+    if (dropDirectives && processPreprocessorDirectives && currentChar == '#' && column == 1) {
+        // Consume exactly what processPreprocessor would
+        advance();
+        skipWhitespace();
+        while (currentChar != '\0' && std::isalpha(currentChar)) {
+            advance();
+        }
+        skipWhitespace();
+        advanceTo(source.find('\n', position));
+        return true;
+    }
+    
+    return false;
+}
+
+Token Lexer::scanToken() {
     if (stateStack.top() == LexerState::IN_COMMENT) {
         // Continue processing the current comment
         return processComment();
@@ -362,8 +589,6 @@ Token Lexer::getNextToken() {
         return processCharLiteral();
     }
     
-    skipWhitespace();
-    
     if (currentChar == '\0') {
         return Token(TokenType::EOF_TOKEN, "", line, column, filename);
     }
@@ -413,6 +638,11 @@ Token Lexer::getNextToken() {
     // Try to match a token using regex rules first
     Token regexToken = recognizeTokenFromRules();
     if (regexToken.type != TokenType::UNKNOWN) {
+        if (regexToken.type == TokenType::IDENTIFIER && tracksSymbolsInline() &&
+            !SymbolTableBuilder::isReservedWord(config.keywordSets, regexToken.lexeme)) {
+            SymbolTableBuilder::recordIdentifier(*symbolTable, regexToken.lexeme, regexToken.location.line,
+                                                 regexToken.location.column);
+        }
         return regexToken;
     }
     
@@ -475,6 +705,46 @@ std::vector<Token> Lexer::tokenize() {
     return tokens;
 }
 
+size_t Lexer::tokenize(const std::function<void(const Token&)>& onToken) {
+    size_t count = 0;
+    Token token = getNextToken();
+    
+    while (token.type != TokenType::EOF_TOKEN) {
+        onToken(token);
+        ++count;
+        token = getNextToken();
+    }
+    
+    onToken(token); // Add EOF token
+    return count + 1;
+}
+
+size_t Lexer::tokenizeRange(size_t begin, size_t end,
+                            const std::function<void(const Token&, size_t)>& onToken) {
+    // Moving forward only needs the newlines in between to be counted
+    if (begin < position) {
+        position = 0;
+        line = 1;
+        column = 1;
+        currentChar = !source.empty() ? source[0] : '\0';
+    }
+    advanceTo(begin);
+    while (stateStack.size() > 1) {
+        stateStack.pop();
+    }
+    
+    size_t count = 0;
+    while (position < end) {
+        Token token = getNextToken();
+        if (token.type == TokenType::EOF_TOKEN) {
+            break;
+        }
+        onToken(token, position);
+        ++count;
+    }
+    return count;
+}
+
 // Token processing methods
 Token Lexer::processIdentifier() {
     std::string lexeme;
@@ -509,16 +779,8 @@ Token Lexer::processIdentifier() {
     
     // Regular identifier
     // Add to symbol table
-    if (symbolTable) {
-        Symbol* symbol = symbolTable->currentScope->lookup(lexeme);
-        
-        if (!symbol) {
-            // New identifier, create symbol
-            symbol = symbolTable->addSymbol(lexeme, SymbolKind::UNKNOWN, "", startLine, startColumn);
-        } else {
-            // Mark as used
-            symbol->setUsed(true);
-        }
+    if (tracksSymbolsInline()) {
+        Symbol* symbol = SymbolTableBuilder::recordIdentifier(*symbolTable, lexeme, startLine, startColumn);
         
         auto attribute = std::make_shared<IdentifierAttribute>(
             symbol->getIsDefined(), false, symbol->getScope() ? symbol->getScope()->getName() : "");
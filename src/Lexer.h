@@ -12,6 +12,10 @@
 #include "Token.h"
 #include "LanguageConfig.h"
 #include "SymbolTable.h"
+#include "TokenFilter.h"
+#include "TokenQuery.h"
+#include "BracketIndex.h"
+#include "SymbolTableBuilder.h"
 
 // Forward declaration
 class TokenStream;
@@ -32,6 +36,9 @@ private:
     // Symbol table for tracking symbols
     std::shared_ptr<SymbolTable> symbolTable;
     
+    // Tokens the caller does not want
+    TokenFilter filter;
+    
     // Preprocessor handling
     bool processPreprocessorDirectives;
     std::stack<bool> conditionalCompilationStack;
@@ -73,12 +80,23 @@ private:
     bool isRawString;
     bool hasEscapeSequences;
     
+    // Bracket pairs of the tokens handed out so far
+    BracketIndex brackets;
+    bool trackBrackets;
+    
+    // Whether scopes and symbols are recorded while scanning
+    SymbolMode symbolMode;
+    bool tracksSymbolsInline() const { return symbolTable && symbolMode == SymbolMode::INLINE; }
+    
     // Helper methods
     void advance();
     void skipWhitespace();
     char peek(int offset = 1) const;
     std::string peekString(int length) const;
     
+    // Move to an absolute position, updating line and column in bulk
+    void advanceTo(size_t target);
+    
     // Token processing methods
     Token processIdentifier();
     Token processNumber();
@@ -88,6 +106,13 @@ private:
     Token processComment();
     Token processPreprocessor();
     
+    // Scan one token starting at the current position
+    Token scanToken();
+    
+    // Skip a comment or directive at the current position if the filter
+    // drops it; returns false if nothing was skipped
+    bool skipFilteredToken();
+    
     // Advanced token recognition
     Token recognizeTokenFromRules();
     bool isStartOfComment(std::string& startDelimiter, std::string& endDelimiter, bool& isDoc);
@@ -113,13 +138,37 @@ public:
     void setPreprocessorEnabled(bool enabled);
     void addIncludePath(const std::string& path);
     
+    // Only hand out tokens accepted by the filter
+    void setTokenFilter(const TokenFilter& tokenFilter);
+    const TokenFilter& getTokenFilter() const;
+    
+    // Match brackets as tokens are handed out; indices in the index count
+    // the tokens returned by getNextToken/tokenize, EOF included
+    void setBracketTracking(bool enabled);
+    const BracketIndex& getBracketIndex() const;
+    
     // Symbol table access
     void setSymbolTable(std::shared_ptr<SymbolTable> table);
     std::shared_ptr<SymbolTable> getSymbolTable() const;
     
+    // INLINE (the default) fills the symbol table while scanning; OFF and
+    // DEFERRED leave it alone, DEFERRED expecting the caller to run a
+    // SymbolTableBuilder over the tokens afterwards
+    void setSymbolMode(SymbolMode mode);
+    SymbolMode getSymbolMode() const;
+    
     // Core lexing methods
     Token getNextToken();
     std::vector<Token> tokenize();
+    // Streaming variant: hands each token (EOF included) to the callback as
+    // soon as it is scanned and returns the number of tokens produced
+    size_t tokenize(const std::function<void(const Token&)>& onToken);
+    // Lex part of the source: start at offset begin, which must be a token
+    // boundary outside comments and strings, and stop after the first token
+    // reaching end. onToken also receives the offset just past each token.
+    // Returns the number of tokens produced.
+    size_t tokenizeRange(size_t begin, size_t end,
+                         const std::function<void(const Token&, size_t)>& onToken);
     TokenStream createTokenStream();
     
     // File handling
@@ -135,22 +184,37 @@ public:
     std::string getTokenSummary(const std::vector<Token>& tokens) const;
 };
 
-// Token stream class for iterating over tokens with lookahead
+// Token stream class for iterating over tokens with lookahead. With an
+// index (built in one pass by buildIndex) skipUntil, nextOccurrence and
+// countInRange are binary searches over sorted position lists; without
+// one they scan.
 class TokenStream {
 private:
     std::vector<Token> tokens;
     size_t position;
     
+    // Positions of each token type and of each distinct lexeme, ascending
+    bool indexed;
+    std::vector<std::vector<size_t>> typePositions;
+    std::unordered_map<std::string, std::vector<size_t>> lexemePositions;
+    
+    const std::vector<size_t>* positionsOf(TokenType type) const;
+    const std::vector<size_t>* positionsOf(const std::string& lexeme) const;
+    
 public:
-    TokenStream(const std::vector<Token>& tokens);
+    TokenStream(const std::vector<Token>& tokens, bool buildIndex = false);
+    TokenStream(std::vector<Token>&& tokens, bool buildIndex = false);
     
     // Stream operations
-    Token current() const;
-    Token next();
-    Token peek(int offset = 1) const;
+    const Token& current() const;
+    const Token& next();
+    const Token& peek(int offset = 1) const;
     bool hasMore() const;
     size_t remaining() const;
     void reset();
+    size_t getPosition() const { return position; }
+    void seek(size_t index);
+    size_t size() const { return tokens.size(); }
     
     // Context information
     std::vector<Token> getContext(int before, int after) const;
@@ -160,11 +224,29 @@ public:
     void skipUntil(TokenType type);
     void skipUntil(const std::string& lexeme);
     
+    // Position index
+    void buildIndex();
+    bool hasIndex() const { return indexed; }
+    
+    // Index of the first matching token at or after from (default: the
+    // current position), or size() if there is none
+    size_t nextOccurrence(TokenType type) const { return nextOccurrence(type, position); }
+    size_t nextOccurrence(TokenType type, size_t from) const;
+    size_t nextOccurrence(const std::string& lexeme) const { return nextOccurrence(lexeme, position); }
+    size_t nextOccurrence(const std::string& lexeme, size_t from) const;
+    
+    // Number of matching tokens with index in [begin, end)
+    size_t countInRange(TokenType type, size_t begin, size_t end) const;
+    size_t countInRange(const std::string& lexeme, size_t begin, size_t end) const;
+    
     // Search operations
     bool lookingAt(TokenType type) const;
     bool lookingAt(const std::string& lexeme) const;
     bool lookingAtSequence(const std::vector<TokenType>& types) const;
     bool lookingAtSequence(const std::vector<std::string>& lexemes) const;
+    
+    // Every match of a token query from the current position on
+    std::vector<QueryMatch> findAll(const TokenQuery& query) const;
 };
 
 #endif // LEXER_H
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+private:
+    const uint8_t* data;
+    size_t length;
+
+public:
+    MappedFile() : data(nullptr), length(0) {}
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map the file; returns false if it can't be opened or mapped
+    bool open(const std::string& filename);
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    const uint8_t* bytes() const { return data; }
+    size_t size() const { return length; }
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,123 @@
+#include "OutputSink.h"
+#include <charconv>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+// OutputSink implementation
+OutputSink::OutputSink(size_t bufferSize)
+    : buffer(bufferSize > 0 ? bufferSize : 1), used(0), totalBytes(0), failed(false) {}
+
+void OutputSink::writeSlow(const char* data, size_t size) {
+    // Top up the buffer, then either buffer the rest or pass large
+    // writes through without an extra copy
+    size_t room = buffer.size() - used;
+    std::memcpy(buffer.data() + used, data, room);
+    used += room;
+    data += room;
+    size -= room;
+    flush();
+
+    if (size >= buffer.size()) {
+        if (!failed && !writeChunk(data, size)) {
+            failed = true;
+        }
+        totalBytes += size;
+        return;
+    }
+
+    std::memcpy(buffer.data(), data, size);
+    used = size;
+}
+
+void OutputSink::writeInt(long long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    write(digits, result.ptr - digits);
+}
+
+void OutputSink::writeUInt(unsigned long long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    write(digits, result.ptr - digits);
+}
+
+bool OutputSink::flush() {
+    if (used > 0) {
+        if (!failed && !writeChunk(buffer.data(), used)) {
+            failed = true;
+        }
+        totalBytes += used;
+        used = 0;
+    }
+    return !failed;
+}
+
+// StringSink implementation
+bool StringSink::writeChunk(const char* data, size_t size) {
+    target.append(data, size);
+    return true;
+}
+
+// FileSink implementation
+FileSink::FileSink(const std::string& filename, size_t bufferSize)
+    : OutputSink(bufferSize), fd(-1), ownsFd(true) {
+    fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+FileSink::FileSink(int fd, size_t bufferSize)
+    : OutputSink(bufferSize), fd(fd), ownsFd(false) {}
+
+FileSink::~FileSink() {
+    close();
+}
+
+bool FileSink::writeChunk(const char* data, size_t size) {
+    if (fd < 0) {
+        return false;
+    }
+
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool FileSink::writeAt(const char* data, size_t size, size_t offset) {
+    if (fd < 0) {
+        return false;
+    }
+
+    while (size > 0) {
+        ssize_t written = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool FileSink::close() {
+    bool ok = flush();
+    if (fd >= 0 && ownsFd) {
+        if (::close(fd) != 0) {
+            ok = false;
+        }
+    }
+    fd = -1;
+    return ok;
+}
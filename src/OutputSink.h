@@ -0,0 +1,118 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+
+// Buffered byte sink used by the exporters. Output is collected in a
+// reusable buffer and handed to the underlying target in large chunks,
+// so formatting never has to materialize the whole document.
+class OutputSink {
+private:
+    std::vector<char> buffer;
+    size_t used;
+    size_t totalBytes;
+    bool failed;
+
+    void writeSlow(const char* data, size_t size);
+
+protected:
+    // Hand a chunk to the underlying target; returns false on failure
+    virtual bool writeChunk(const char* data, size_t size) = 0;
+
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    explicit OutputSink(size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    virtual ~OutputSink() = default;
+
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    // Append raw bytes
+    void write(const char* data, size_t size) {
+        if (size <= buffer.size() - used) {
+            std::memcpy(buffer.data() + used, data, size);
+            used += size;
+        } else {
+            writeSlow(data, size);
+        }
+    }
+    void write(std::string_view text) { write(text.data(), text.size()); }
+    void put(char c) {
+        if (used == buffer.size()) {
+            flush();
+        }
+        buffer[used++] = c;
+    }
+
+    // Append a decimal number (formatted with std::to_chars)
+    void writeInt(long long value);
+    void writeUInt(unsigned long long value);
+
+    // Push buffered bytes to the target
+    bool flush();
+
+    bool good() const { return !failed; }
+
+    // Total number of bytes accepted so far (buffered or written)
+    size_t bytesWritten() const { return totalBytes + used; }
+};
+
+// Sink that appends to a string (used by exportToString)
+class StringSink : public OutputSink {
+private:
+    std::string& target;
+
+protected:
+    bool writeChunk(const char* data, size_t size) override;
+
+public:
+    explicit StringSink(std::string& target, size_t bufferSize = 64 * 1024)
+        : OutputSink(bufferSize), target(target) {}
+    ~StringSink() override { flush(); }
+};
+
+// Sink that discards its input (for writers that only forward tokens)
+class NullSink : public OutputSink {
+protected:
+    bool writeChunk(const char*, size_t) override { return true; }
+
+public:
+    NullSink() : OutputSink(64) {}
+};
+
+// Sink that writes straight to a file descriptor
+class FileSink : public OutputSink {
+private:
+    int fd;
+    bool ownsFd;
+
+protected:
+    bool writeChunk(const char* data, size_t size) override;
+
+public:
+    // Open (create/truncate) a file for writing
+    explicit FileSink(const std::string& filename, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+    // Wrap an already open descriptor (e.g. stdout); it is not closed
+    explicit FileSink(int fd, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+    ~FileSink() override;
+
+    bool isOpen() const { return fd >= 0; }
+    int descriptor() const { return fd; }
+
+    // Write directly at an absolute file offset, bypassing the buffer and
+    // the file position (pwrite). Safe to call from several threads for
+    // disjoint ranges.
+    bool writeAt(const char* data, size_t size, size_t offset);
+
+    // Flush and close the descriptor if we own it
+    bool close();
+};
+
+#endif // OUTPUT_SINK_H
@@ -0,0 +1,140 @@
+#include "PatternMatcher.h"
+#include <fstream>
+#include <deque>
+
+MultiPatternMatcher::MultiPatternMatcher() : compiled(false) {}
+
+void MultiPatternMatcher::addPattern(const std::string& pattern) {
+    if (!pattern.empty()) {
+        patterns.push_back(pattern);
+        compiled = false;
+    }
+}
+
+bool MultiPatternMatcher::loadFile(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        addPattern(line);
+    }
+    return true;
+}
+
+void MultiPatternMatcher::compile() {
+    // Trie: state 0 is the root, -1 marks a missing edge
+    transitions.assign(256, -1);
+    std::vector<std::vector<uint32_t>> own(1);
+    firstBytes = ByteSet();
+
+    for (uint32_t index = 0; index < patterns.size(); ++index) {
+        const std::string& pattern = patterns[index];
+        firstBytes.add(static_cast<unsigned char>(pattern[0]));
+
+        int32_t state = 0;
+        for (char c : pattern) {
+            size_t edge = static_cast<size_t>(state) * 256 + static_cast<unsigned char>(c);
+            if (transitions[edge] < 0) {
+                transitions[edge] = static_cast<int32_t>(own.size());
+                own.emplace_back();
+                transitions.resize(transitions.size() + 256, -1);
+            }
+            state = transitions[edge];
+        }
+        own[state].push_back(index);
+    }
+
+    // Breadth-first: fill missing edges from the failure state and merge
+    // each state's outputs with those of its failure state
+    const size_t stateTotal = own.size();
+    std::vector<int32_t> failure(stateTotal, 0);
+    std::vector<std::vector<uint32_t>> merged(stateTotal);
+    std::deque<int32_t> queue;
+
+    for (size_t c = 0; c < 256; ++c) {
+        int32_t& next = transitions[c];
+        if (next < 0) {
+            next = 0;
+        } else {
+            queue.push_back(next);
+        }
+    }
+
+    merged[0] = own[0];
+    while (!queue.empty()) {
+        int32_t state = queue.front();
+        queue.pop_front();
+
+        merged[state] = own[state];
+        const auto& inherited = merged[failure[state]];
+        merged[state].insert(merged[state].end(), inherited.begin(), inherited.end());
+
+        for (size_t c = 0; c < 256; ++c) {
+            size_t edge = static_cast<size_t>(state) * 256 + c;
+            int32_t fallback = transitions[static_cast<size_t>(failure[state]) * 256 + c];
+            if (transitions[edge] < 0) {
+                transitions[edge] = fallback;
+            } else {
+                failure[transitions[edge]] = fallback;
+                queue.push_back(transitions[edge]);
+            }
+        }
+    }
+
+    outputStart.assign(stateTotal + 1, 0);
+    outputs.clear();
+    for (size_t state = 0; state < stateTotal; ++state) {
+        outputStart[state] = static_cast<uint32_t>(outputs.size());
+        outputs.insert(outputs.end(), merged[state].begin(), merged[state].end());
+    }
+    outputStart[stateTotal] = static_cast<uint32_t>(outputs.size());
+    compiled = true;
+}
+
+void MultiPatternMatcher::scan(std::string_view text, const std::function<void(size_t, size_t)>& onMatch) {
+    if (!compiled) {
+        compile();
+    }
+    if (patterns.empty()) {
+        return;
+    }
+
+    const size_t size = text.size();
+    int32_t state = 0;
+    for (size_t i = 0; i < size; ++i) {
+        if (state == 0) {
+            i += findFirstOf(text.data() + i, size - i, firstBytes);
+            if (i >= size) {
+                break;
+            }
+        }
+
+        state = transitions[static_cast<size_t>(state) * 256 + static_cast<unsigned char>(text[i])];
+        for (uint32_t k = outputStart[state]; k < outputStart[state + 1]; ++k) {
+            size_t index = outputs[k];
+            onMatch(index, i + 1 - patterns[index].size());
+        }
+    }
+}
+
+void MultiPatternMatcher::scan(const Token& token, const std::function<void(const PatternHit&)>& onHit) {
+    const std::string& text = token.lexeme;
+    scan(text, [&](size_t index, size_t start) {
+        // Position of the match inside a possibly multi-line lexeme
+        SourceLocation location = token.location;
+        size_t lineStart = text.rfind('\n', start == 0 ? std::string::npos : start - 1);
+        if (start == 0 || lineStart == std::string::npos) {
+            location.column += static_cast<int>(start);
+        } else {
+            location.line += static_cast<int>(countByte(text.data(), lineStart + 1, '\n'));
+            location.column = static_cast<int>(start - lineStart);
+        }
+        onHit({index, location});
+    });
+}
@@ -0,0 +1,57 @@
+#ifndef PATTERN_MATCHER_H
+#define PATTERN_MATCHER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include "Token.h"
+#include "ByteScan.h"
+
+// A literal pattern found inside a token. Line and column are those of
+// the match; the offset is the enclosing token's.
+struct PatternHit {
+    size_t pattern;
+    SourceLocation location;
+};
+
+// Finds many literal strings at once with an Aho-Corasick automaton. The
+// trie is compiled into a dense DFA (256 transitions per state, failure
+// links folded in), so scanning is one table lookup per byte. While the
+// automaton is in its root state, findFirstOf jumps straight to the next
+// byte that can start a pattern.
+class MultiPatternMatcher {
+private:
+    std::vector<std::string> patterns;
+    std::vector<int32_t> transitions;
+    std::vector<uint32_t> outputStart;
+    std::vector<uint32_t> outputs;
+    ByteSet firstBytes;
+    bool compiled;
+
+public:
+    MultiPatternMatcher();
+
+    // Add a pattern; empty patterns are ignored
+    void addPattern(const std::string& pattern);
+
+    // Read one pattern per line; blank lines are skipped
+    bool loadFile(const std::string& filename);
+
+    // Build the automaton; called by scan if needed
+    void compile();
+
+    size_t size() const { return patterns.size(); }
+    size_t stateCount() const { return outputStart.empty() ? 0 : outputStart.size() - 1; }
+    const std::string& pattern(size_t index) const { return patterns[index]; }
+
+    // Call onMatch(pattern, start offset) for every occurrence in text,
+    // overlapping ones included, in order of their end offset
+    void scan(std::string_view text, const std::function<void(size_t, size_t)>& onMatch);
+
+    // Scan a token's lexeme and report hits at their source position
+    void scan(const Token& token, const std::function<void(const PatternHit&)>& onHit);
+};
+
+#endif // PATTERN_MATCHER_H
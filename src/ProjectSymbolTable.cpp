@@ -0,0 +1,99 @@
+#include "ProjectSymbolTable.h"
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+bool inputOrder(uint32_t fileA, uint32_t ordinalA, uint32_t fileB, uint32_t ordinalB) {
+    return fileA != fileB ? fileA < fileB : ordinalA < ordinalB;
+}
+
+} // namespace
+
+ProjectSymbolTable::ProjectSymbolTable(size_t fileCount, size_t shards)
+    : filenames(fileCount), tables(fileCount), shards(new Shard[std::max<size_t>(shards, 1)]),
+      shardCount(std::max<size_t>(shards, 1)), sorted(true) {}
+
+ProjectSymbolTable::Shard& ProjectSymbolTable::shardFor(const std::string& name) const {
+    return shards[std::hash<std::string>()(name) % shardCount];
+}
+
+void ProjectSymbolTable::addFile(size_t file, const std::string& filename, std::shared_ptr<SymbolTable> table) {
+    filenames[file] = filename;
+    tables[file] = table;
+    if (!table) {
+        return;
+    }
+
+    // Group the file's symbols by shard so each lock is taken once
+    std::vector<std::vector<Entry>> pending(shardCount);
+    for (size_t i = 0; i < table->symbolCount(); ++i) {
+        const Symbol& symbol = table->symbolAt(i);
+        size_t shard = std::hash<std::string>()(symbol.getName()) % shardCount;
+        pending[shard].push_back({static_cast<uint32_t>(file), static_cast<uint32_t>(i), &symbol});
+    }
+
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+        if (pending[shard].empty()) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(shards[shard].mutex);
+        for (const Entry& entry : pending[shard]) {
+            shards[shard].names[entry.symbol->getName()].push_back(entry);
+        }
+    }
+    sorted = false;
+}
+
+void ProjectSymbolTable::finish() {
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+        for (auto& name : shards[shard].names) {
+            std::sort(name.second.begin(), name.second.end(), [](const Entry& a, const Entry& b) {
+                return inputOrder(a.file, a.ordinal, b.file, b.ordinal);
+            });
+        }
+    }
+    sorted = true;
+}
+
+std::vector<ProjectSymbol> ProjectSymbolTable::findSymbols(const std::string& name) const {
+    Shard& shard = shardFor(name);
+    std::vector<Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.names.find(name);
+        if (it == shard.names.end()) {
+            return {};
+        }
+        entries = it->second;
+    }
+    if (!sorted) {
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return inputOrder(a.file, a.ordinal, b.file, b.ordinal);
+        });
+    }
+
+    std::vector<ProjectSymbol> result;
+    result.reserve(entries.size());
+    for (const Entry& entry : entries) {
+        result.push_back({entry.file, entry.symbol});
+    }
+    return result;
+}
+
+size_t ProjectSymbolTable::nameCount() const {
+    size_t total = 0;
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+        std::lock_guard<std::mutex> lock(shards[shard].mutex);
+        total += shards[shard].names.size();
+    }
+    return total;
+}
+
+size_t ProjectSymbolTable::symbolCount() const {
+    size_t total = 0;
+    for (const auto& table : tables) {
+        total += table ? table->symbolCount() : 0;
+    }
+    return total;
+}
@@ -0,0 +1,71 @@
+#ifndef PROJECT_SYMBOL_TABLE_H
+#define PROJECT_SYMBOL_TABLE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include "SymbolTable.h"
+
+// A symbol found in the project index, with the file it came from
+struct ProjectSymbol {
+    uint32_t file;
+    const Symbol* symbol;
+};
+
+// Project-wide symbol index for parallel lexing. Each file's scope tree
+// is an ordinary SymbolTable built by whichever thread lexed the file;
+// addFile then publishes its symbols into a global name index split into
+// shards by name hash, each with its own lock, so workers only contend
+// when they insert names that land in the same shard.
+//
+// Results do not depend on scheduling: every entry carries the file's
+// index in the input and the symbol's position in that file's table,
+// and lookups return entries in that order.
+class ProjectSymbolTable {
+private:
+    struct Entry {
+        uint32_t file;
+        uint32_t ordinal;
+        const Symbol* symbol;
+    };
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::vector<Entry>> names;
+    };
+
+    std::vector<std::string> filenames;
+    std::vector<std::shared_ptr<SymbolTable>> tables;
+    std::unique_ptr<Shard[]> shards;
+    size_t shardCount;
+    std::atomic<bool> sorted; // cleared by addFile from any thread
+
+    Shard& shardFor(const std::string& name) const;
+
+public:
+    // fileCount is the number of input files; files are added by index
+    explicit ProjectSymbolTable(size_t fileCount, size_t shards = 64);
+
+    // Publish a file's symbols; safe to call from several threads at once
+    // as long as each file index is added once
+    void addFile(size_t file, const std::string& filename, std::shared_ptr<SymbolTable> table);
+
+    // Sort every name's entries into input order; call once all files are
+    // added so later lookups need not sort
+    void finish();
+
+    // Every symbol with this name, in input order
+    std::vector<ProjectSymbol> findSymbols(const std::string& name) const;
+
+    size_t fileCount() const { return filenames.size(); }
+    const std::string& getFilename(size_t file) const { return filenames[file]; }
+    std::shared_ptr<SymbolTable> getFileTable(size_t file) const { return tables[file]; }
+
+    // Number of distinct names and of symbols across all files
+    size_t nameCount() const;
+    size_t symbolCount() const;
+};
+
+#endif // PROJECT_SYMBOL_TABLE_H
@@ -0,0 +1,64 @@
+#include "ScopeIndex.h"
+#include <algorithm>
+#include <climits>
+#include <unordered_set>
+
+ScopeIndex::ScopeIndex() : scopeTotal(0) {}
+
+ScopeIndex::ScopeIndex(const Scope* root) : scopeTotal(0) {
+    build(root);
+}
+
+void ScopeIndex::build(const Scope* root) {
+    boundaries.clear();
+    scopeTotal = 0;
+    if (root) {
+        boundaries.push_back({INT_MIN, INT_MIN, root});
+        addScope(root);
+    }
+}
+
+void ScopeIndex::addScope(const Scope* scope) {
+    ++scopeTotal;
+    for (const Scope* child : scope->getChildren()) {
+        boundaries.push_back({child->getStartLine(), child->getStartColumn(), child});
+        addScope(child);
+        if (child->getEndLine() < 0) {
+            // Never closed: it and its children run to the end
+            return;
+        }
+        boundaries.push_back({child->getEndLine(), child->getEndColumn() + 1, scope});
+    }
+}
+
+const Scope* ScopeIndex::scopeAt(int line, int column) const {
+    auto after = std::upper_bound(boundaries.begin(), boundaries.end(), std::make_pair(line, column),
+                                  [](const std::pair<int, int>& position, const Boundary& boundary) {
+                                      return position < std::make_pair(boundary.line, boundary.column);
+                                  });
+    return after == boundaries.begin() ? nullptr : std::prev(after)->scope;
+}
+
+std::vector<const Symbol*> ScopeIndex::visibleSymbols(int line, int column) const {
+    std::vector<const Symbol*> visible;
+    std::unordered_set<uint32_t> seen;
+    const auto position = std::make_pair(line, column);
+    for (const Scope* scope = scopeAt(line, column); scope; scope = scope->getParent()) {
+        size_t first = visible.size();
+        for (const Symbol* symbol : scope->getSymbols()) {
+            // Names declared further on are not in scope yet, nor do they
+            // shadow an outer declaration
+            if (std::make_pair(symbol->getLine(), symbol->getColumn()) > position) {
+                continue;
+            }
+            if (seen.insert(symbol->getNameId()).second) {
+                visible.push_back(symbol);
+            }
+        }
+        // Innermost scope first, each in declaration order
+        std::sort(visible.begin() + first, visible.end(), [](const Symbol* a, const Symbol* b) {
+            return std::make_pair(a->getLine(), a->getColumn()) < std::make_pair(b->getLine(), b->getColumn());
+        });
+    }
+    return visible;
+}
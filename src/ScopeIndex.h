@@ -0,0 +1,45 @@
+#ifndef SCOPE_INDEX_H
+#define SCOPE_INDEX_H
+
+#include <vector>
+#include "SymbolTable.h"
+
+// Answers "which scope encloses line:column" for one file's scope tree in
+// logarithmic time. Scopes nest, so the innermost enclosing scope only
+// changes where a scope starts or ends: the tree is flattened once into
+// those boundaries, sorted by position, and a query is a binary search.
+class ScopeIndex {
+private:
+    // From (line, column) on, up to the next boundary, scope is innermost
+    struct Boundary {
+        int line;
+        int column;
+        const Scope* scope;
+    };
+    std::vector<Boundary> boundaries;
+    size_t scopeTotal;
+
+    void addScope(const Scope* scope);
+
+public:
+    ScopeIndex();
+    explicit ScopeIndex(const Scope* root);
+
+    // Index the tree under root (e.g. SymbolTable::getGlobalScope())
+    void build(const Scope* root);
+
+    size_t scopeCount() const { return scopeTotal; }
+
+    // Innermost scope containing the position, or nullptr if the index is
+    // empty. A scope spans from its opening to its closing brace,
+    // inclusive; a scope that was never closed extends to the end.
+    const Scope* scopeAt(int line, int column) const;
+
+    // Symbols visible at the position: those of the enclosing scope and
+    // its ancestors declared at or before it, inner declarations shadowing
+    // outer ones. Scopes open on '{', so a function's parameters belong to
+    // the scope around the function, not to its body.
+    std::vector<const Symbol*> visibleSymbols(int line, int column) const;
+};
+
+#endif // SCOPE_INDEX_H
@@ -0,0 +1,214 @@
+#include "SymbolSearchIndex.h"
+#include <algorithm>
+
+namespace {
+
+// A tail this short is cheap to scan, so it is not merged yet
+const size_t MIN_PENDING = 256;
+
+// ASCII case folding; identifiers outside ASCII are matched as bytes
+inline char foldByte(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+std::string foldCase(const std::string& text) {
+    std::string result(text);
+    for (char& c : result) {
+        c = foldByte(c);
+    }
+    return result;
+}
+
+// Distinct trigrams of the case-folded text, padded with two spaces in
+// front and one behind
+std::vector<uint32_t> trigramsOf(const std::string& text) {
+    std::string padded = "  " + foldCase(text) + " ";
+    std::vector<uint32_t> result;
+    result.reserve(padded.size() - 2);
+    for (size_t i = 0; i + 2 < padded.size(); ++i) {
+        result.push_back((static_cast<uint32_t>(static_cast<unsigned char>(padded[i])) << 16) |
+                         (static_cast<uint32_t>(static_cast<unsigned char>(padded[i + 1])) << 8) |
+                         static_cast<unsigned char>(padded[i + 2]));
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+bool startsWith(const std::string& text, const std::string& prefix) {
+    return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Position of folded (already lower case) in text ignoring case, or npos
+size_t findIgnoringCase(const std::string& text, const std::string& folded) {
+    for (size_t start = 0; start + folded.size() <= text.size(); ++start) {
+        size_t i = 0;
+        while (i < folded.size() && foldByte(text[start + i]) == folded[i]) {
+            ++i;
+        }
+        if (i == folded.size()) {
+            return start;
+        }
+    }
+    return std::string::npos;
+}
+
+} // namespace
+
+SymbolSearchIndex::SymbolSearchIndex(const SymbolTable& table) : table(table), indexed(0) {
+    update();
+}
+
+void SymbolSearchIndex::update() {
+    const auto& names = table.getSymbolNames();
+    for (; indexed < names.size(); ++indexed) {
+        const uint32_t nameId = names[indexed];
+        pending.push_back(nameId);
+
+        auto grams = trigramsOf(nameOf(nameId));
+        for (uint32_t gram : grams) {
+            trigrams[gram].push_back(static_cast<uint32_t>(indexed));
+        }
+        trigramCounts.push_back(static_cast<uint16_t>(std::min<size_t>(grams.size(), UINT16_MAX)));
+        shared.push_back(0);
+    }
+    if (pending.size() > std::max(MIN_PENDING, sorted.size() / 8)) {
+        mergePending();
+    }
+}
+
+void SymbolSearchIndex::mergePending() {
+    auto byName = [this](uint32_t a, uint32_t b) { return nameOf(a) < nameOf(b); };
+    std::sort(pending.begin(), pending.end(), byName);
+    size_t middle = sorted.size();
+    sorted.insert(sorted.end(), pending.begin(), pending.end());
+    std::inplace_merge(sorted.begin(), sorted.begin() + middle, sorted.end(), byName);
+    pending.clear();
+}
+
+std::vector<SymbolMatch> SymbolSearchIndex::prefix(const std::string& text, size_t limit) {
+    update();
+    std::vector<uint32_t> found;
+
+    auto first = std::lower_bound(sorted.begin(), sorted.end(), text,
+                                  [this](uint32_t id, const std::string& value) { return nameOf(id) < value; });
+    for (auto it = first; it != sorted.end() && found.size() < limit && startsWith(nameOf(*it), text); ++it) {
+        found.push_back(*it);
+    }
+    for (uint32_t id : pending) {
+        if (startsWith(nameOf(id), text)) {
+            found.push_back(id);
+        }
+    }
+
+    // The tail is unsorted: order everything and cut to the limit
+    std::sort(found.begin(), found.end(), [this](uint32_t a, uint32_t b) { return nameOf(a) < nameOf(b); });
+    found.resize(std::min(found.size(), limit));
+
+    std::vector<SymbolMatch> result;
+    result.reserve(found.size());
+    for (uint32_t id : found) {
+        result.push_back({id, &nameOf(id), 1.0});
+    }
+    return result;
+}
+
+std::vector<SymbolMatch> SymbolSearchIndex::fuzzy(const std::string& query, size_t limit) {
+    update();
+    if (query.empty() || limit == 0) {
+        return {};
+    }
+    const auto& names = table.getSymbolNames();
+    const auto queryGrams = trigramsOf(query);
+    const size_t queryCount = queryGrams.size();
+    const std::string folded = foldCase(query);
+
+    // Candidates must share at least minimum trigrams with the query. That
+    // never excludes a name containing the query, which lacks at most the
+    // three trigrams touching the query's padding.
+    const size_t minimum = std::max<size_t>(1, std::min((queryCount + 1) / 2, queryCount - std::min<size_t>(queryCount, 3)));
+
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (uint32_t gram : queryGrams) {
+        auto it = trigrams.find(gram);
+        if (it != trigrams.end()) {
+            lists.push_back(&it->second);
+        }
+    }
+    std::sort(lists.begin(), lists.end(), [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) {
+        return a->size() < b->size();
+    });
+
+    // A name in none of the rarest queryCount - minimum + 1 lists shares
+    // fewer than minimum trigrams, so only those lists produce candidates;
+    // the common ones are only probed for names already found
+    const size_t scanned = std::min(lists.size(), queryCount - minimum + 1);
+    for (size_t i = 0; i < scanned; ++i) {
+        for (uint32_t position : *lists[i]) {
+            if (shared[position]++ == 0) {
+                touched.push_back(position);
+            }
+        }
+    }
+    for (size_t i = scanned; i < lists.size(); ++i) {
+        const auto& list = *lists[i];
+        if (touched.size() * 16 < list.size()) {
+            // Posting lists are in position order, so probe them
+            for (uint32_t position : touched) {
+                if (std::binary_search(list.begin(), list.end(), position)) {
+                    ++shared[position];
+                }
+            }
+        } else {
+            for (uint32_t position : list) {
+                if (shared[position] != 0) {
+                    ++shared[position];
+                }
+            }
+        }
+    }
+
+    struct Candidate {
+        uint32_t position;
+        int tier; // 2: starts with the query, 1: contains it, 0: neither
+        double score;
+        size_t length;
+    };
+    std::vector<Candidate> candidates;
+    for (uint32_t position : touched) {
+        const size_t common = shared[position];
+        shared[position] = 0;
+        if (common < minimum) {
+            continue;
+        }
+        const std::string& name = nameOf(names[position]);
+
+        // Containing the query means sharing all its trigrams except the
+        // three that touch its padding, so only then is it worth checking
+        int tier = 0;
+        if (common + 3 >= queryCount) {
+            size_t at = findIgnoringCase(name, folded);
+            tier = at == 0 ? 2 : at != std::string::npos ? 1 : 0;
+        }
+        double score = static_cast<double>(common) / (queryCount + trigramCounts[position] - common);
+        candidates.push_back({position, tier, score, name.size()});
+    }
+    touched.clear();
+
+    auto better = [&](const Candidate& a, const Candidate& b) {
+        if (a.tier != b.tier) return a.tier > b.tier;
+        if (a.score != b.score) return a.score > b.score;
+        if (a.length != b.length) return a.length < b.length;
+        return nameOf(names[a.position]) < nameOf(names[b.position]);
+    };
+    const size_t count = std::min(limit, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), better);
+
+    std::vector<SymbolMatch> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t nameId = names[candidates[i].position];
+        result.push_back({nameId, &nameOf(nameId), candidates[i].score});
+    }
+    return result;
+}
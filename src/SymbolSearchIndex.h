@@ -0,0 +1,65 @@
+#ifndef SYMBOL_SEARCH_INDEX_H
+#define SYMBOL_SEARCH_INDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "SymbolTable.h"
+
+// A name found by a search; the table's findSymbols(nameId) gives its symbols
+struct SymbolMatch {
+    uint32_t nameId;
+    const std::string* name;
+    double score; // 1 for prefix matches, trigram similarity for fuzzy ones
+};
+
+// Prefix and fuzzy lookup over the names in a SymbolTable, for completion
+// and "go to symbol". Names are indexed as the table gains them: every
+// query first indexes the names added since the previous one.
+//
+// Prefix queries binary-search a sorted array of names. New names go to a
+// small unsorted tail that is scanned by queries and merged into the
+// array once it grows past an eighth of it.
+//
+// Fuzzy queries use posting lists of case-folded trigrams (names are padded
+// at both ends, so short names and their starts get trigrams too). Every
+// name sharing a trigram with the query is a candidate. Names starting with
+// the query, ignoring case, rank first, then names containing it, then the
+// rest; within each group by the Jaccard similarity of the trigram sets,
+// then shorter and alphabetically earlier names first.
+class SymbolSearchIndex {
+private:
+    const SymbolTable& table;
+    size_t indexed; // entries of table.getSymbolNames() indexed so far
+
+    std::vector<uint32_t> sorted;  // name ids in byte order
+    std::vector<uint32_t> pending; // name ids not yet merged into sorted
+
+    // Posting lists hold positions in table.getSymbolNames()
+    std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams;
+    std::vector<uint16_t> trigramCounts;
+
+    // Scratch for fuzzy scoring, one counter per indexed name
+    std::vector<uint16_t> shared;
+    std::vector<uint32_t> touched;
+
+    const std::string& nameOf(uint32_t nameId) const { return table.getNames().name(nameId); }
+    void mergePending();
+
+public:
+    explicit SymbolSearchIndex(const SymbolTable& table);
+
+    // Index names the table gained since the last call
+    void update();
+
+    size_t size() const { return indexed; }
+
+    // Up to limit names starting with prefix (case-sensitive), in byte order
+    std::vector<SymbolMatch> prefix(const std::string& prefix, size_t limit);
+
+    // The limit best fuzzy matches for query, best first
+    std::vector<SymbolMatch> fuzzy(const std::string& query, size_t limit);
+};
+
+#endif // SYMBOL_SEARCH_INDEX_H
@@ -1,20 +1,90 @@
 #include "SymbolTable.h"
 #include <sstream>
+#include <algorithm>
+
+// NamePool implementation
+NamePool::NamePool() {
+    intern("");
+}
+
+uint32_t NamePool::intern(std::string_view name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(names.size());
+    names.emplace_back(name);
+    ids.emplace(names.back(), id);
+    return id;
+}
+
+uint32_t NamePool::find(std::string_view name) const {
+    auto it = ids.find(name);
+    return it != ids.end() ? it->second : NONE;
+}
+
+// SymbolIdMap implementation
+size_t SymbolIdMap::slotFor(uint32_t key) const {
+    // Fibonacci hashing spreads the dense ids over the table
+    return (static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull >> 32) & (slots.size() - 1);
+}
+
+Symbol* SymbolIdMap::find(uint32_t key) const {
+    if (slots.empty()) {
+        return nullptr;
+    }
+    for (size_t i = slotFor(key);; i = (i + 1) & (slots.size() - 1)) {
+        if (slots[i].key == key) {
+            return slots[i].value;
+        }
+        if (slots[i].key == EMPTY) {
+            return nullptr;
+        }
+    }
+}
+
+void SymbolIdMap::insert(uint32_t key, Symbol* value) {
+    // Keep the load factor at or below 3/4
+    if ((count + 1) * 4 > slots.size() * 3) {
+        grow();
+    }
+    size_t i = slotFor(key);
+    while (slots[i].key != EMPTY && slots[i].key != key) {
+        i = (i + 1) & (slots.size() - 1);
+    }
+    if (slots[i].key == EMPTY) {
+        ++count;
+    }
+    slots[i] = {key, value};
+}
+
+void SymbolIdMap::grow() {
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.assign(old.empty() ? 8 : old.size() * 2, Slot{EMPTY, nullptr});
+    for (const Slot& slot : old) {
+        if (slot.key != EMPTY) {
+            size_t i = slotFor(slot.key);
+            while (slots[i].key != EMPTY) {
+                i = (i + 1) & (slots.size() - 1);
+            }
+            slots[i] = slot;
+        }
+    }
+}
 
 // Symbol implementation
-Symbol::Symbol(const std::string& name, SymbolKind kind, const std::string& type, 
-               int line, int column, const std::string& filename,
+Symbol::Symbol(NamePool* names, uint32_t nameId, SymbolKind kind, uint32_t typeId,
+               int line, int column, uint32_t filenameId,
                bool isDefined, Scope* scope)
-    : name(name), kind(kind), type(type), line(line), column(column), 
-      filename(filename), isDefined(isDefined), isUsed(false), scope(scope),
-      isStatic(false), isConst(false), isPublic(false), isProtected(false), 
-      isPrivate(false), isExported(false), isImported(false) {}
+    : names(names), scope(scope), nameId(nameId), typeId(typeId), filenameId(filenameId),
+      line(line), column(column), kind(kind), flags(isDefined ? DEFINED : 0) {}
 
 std::string Symbol::toString() const {
     std::stringstream ss;
     
     // Basic symbol info
-    ss << "Symbol: " << name;
+    ss << "Symbol: " << getName();
     
     // Kind info
     ss << " (";
@@ -36,57 +106,57 @@ std::string Symbol::toString() const {
     ss << ")";
     
     // Type info if available
-    if (!type.empty()) {
-        ss << " Type: " << type;
+    if (!getType().empty()) {
+        ss << " Type: " << getType();
     }
     
     // Location
-    ss << " at " << filename << ":" << line << ":" << column;
+    ss << " at " << getFilename() << ":" << line << ":" << column;
     
     // Definition/use status
-    ss << " [" << (isDefined ? "Defined" : "Declared");
-    ss << ", " << (isUsed ? "Used" : "Unused") << "]";
+    ss << " [" << (getIsDefined() ? "Defined" : "Declared");
+    ss << ", " << (getIsUsed() ? "Used" : "Unused") << "]";
     
     // Attributes
     bool hasAttributes = false;
     ss << " Attributes: [";
     
-    if (isStatic) {
+    if (getIsStatic()) {
         ss << "static";
         hasAttributes = true;
     }
     
-    if (isConst) {
+    if (getIsConst()) {
         if (hasAttributes) ss << ", ";
         ss << "const";
         hasAttributes = true;
     }
     
-    if (isPublic) {
+    if (getIsPublic()) {
         if (hasAttributes) ss << ", ";
         ss << "public";
         hasAttributes = true;
     }
     
-    if (isProtected) {
+    if (getIsProtected()) {
         if (hasAttributes) ss << ", ";
         ss << "protected";
         hasAttributes = true;
     }
     
-    if (isPrivate) {
+    if (getIsPrivate()) {
         if (hasAttributes) ss << ", ";
         ss << "private";
         hasAttributes = true;
     }
     
-    if (isExported) {
+    if (getIsExported()) {
         if (hasAttributes) ss << ", ";
         ss << "exported";
         hasAttributes = true;
     }
     
-    if (isImported) {
+    if (getIsImported()) {
         if (hasAttributes) ss << ", ";
         ss << "imported";
         hasAttributes = true;
@@ -102,65 +172,94 @@ std::string Symbol::toString() const {
 }
 
 // Scope implementation
-Scope::Scope(const std::string& name, ScopeType type, 
+Scope::Scope(SymbolTable* table, uint32_t nameId, ScopeType type, 
              int startLine, int startColumn, 
-             const std::string& filename, Scope* parent)
-    : name(name), type(type), startLine(startLine), startColumn(startColumn),
-      endLine(-1), endColumn(-1), filename(filename), parent(parent) {}
+             uint32_t filenameId, Scope* parent)
+    : table(table), nameId(nameId), type(type), startLine(startLine), startColumn(startColumn),
+      endLine(-1), endColumn(-1), filenameId(filenameId), parent(parent) {}
+
+const std::string& Scope::getName() const {
+    return table->names.name(nameId);
+}
+
+const std::string& Scope::getFilename() const {
+    return table->names.name(filenameId);
+}
 
 Scope* Scope::createChildScope(const std::string& name, ScopeType type, 
                               int startLine, int startColumn) {
-    auto childScope = std::make_unique<Scope>(name, type, startLine, startColumn, filename, this);
-    Scope* childPtr = childScope.get();
-    children.push_back(std::move(childScope));
+    table->scopeArena.emplace_back(table, table->names.intern(name), type, startLine, startColumn,
+                                   filenameId, this);
+    Scope* childPtr = &table->scopeArena.back();
+    children.push_back(childPtr);
+    return childPtr;
+}
+
+Scope* Scope::createChildScope(const std::string& name, ScopeType type, 
+                              int startLine, int startColumn, const std::string& filename) {
+    table->scopeArena.emplace_back(table, table->names.intern(name), type, startLine, startColumn,
+                                   table->names.intern(filename), this);
+    Scope* childPtr = &table->scopeArena.back();
+    children.push_back(childPtr);
     return childPtr;
 }
 
 Symbol* Scope::addSymbol(const std::string& name, SymbolKind kind, const std::string& type, 
                         int line, int column, bool isDefined) {
-    auto symbol = std::make_unique<Symbol>(name, kind, type, line, column, filename, isDefined, this);
-    Symbol* symbolPtr = symbol.get();
-    symbols[name] = std::move(symbol);
+    NamePool& names = table->names;
+    uint32_t id = names.intern(name);
+    table->symbolArena.emplace_back(&names, id, kind, names.intern(type), line, column, filenameId,
+                                    isDefined, this);
+    Symbol* symbolPtr = &table->symbolArena.back();
+    
+    // A redeclaration replaces the earlier symbol in this scope
+    Symbol* previous = symbolIndex.find(id);
+    if (previous) {
+        *std::find(symbols.begin(), symbols.end(), previous) = symbolPtr;
+    } else {
+        symbols.push_back(symbolPtr);
+    }
+    symbolIndex.insert(id, symbolPtr);
     return symbolPtr;
 }
 
 Symbol* Scope::findSymbolInScope(const std::string& name) const {
-    auto it = symbols.find(name);
-    if (it != symbols.end()) {
-        return it->second.get();
-    }
-    return nullptr;
+    uint32_t id = table->names.find(name);
+    return id != NamePool::NONE ? symbolIndex.find(id) : nullptr;
 }
 
 Symbol* Scope::findSymbol(const std::string& name) {
-    Symbol* symbol = findSymbolInScope(name);
-    if (symbol) {
-        return symbol;
+    uint32_t id = table->names.find(name);
+    if (id == NamePool::NONE) {
+        return nullptr;
     }
     
-    // Look in child scopes
-    for (auto& child : children) {
-        symbol = child->findSymbol(name);
-        if (symbol) {
+    // Depth-first through the child scopes without recursion
+    std::vector<Scope*> pending{this};
+    while (!pending.empty()) {
+        Scope* scope = pending.back();
+        pending.pop_back();
+        if (Symbol* symbol = scope->symbolIndex.find(id)) {
             return symbol;
         }
+        pending.insert(pending.end(), scope->children.rbegin(), scope->children.rend());
     }
     
     return nullptr;
 }
 
 Symbol* Scope::lookup(const std::string& name) {
-    // First check this scope
-    Symbol* symbol = findSymbolInScope(name);
-    if (symbol) {
-        return symbol;
-    }
-    
-    // Then check parent scopes
-    if (parent) {
-        return parent->lookup(name);
+    uint32_t id = table->names.find(name);
+    return id != NamePool::NONE ? lookup(id) : nullptr;
+}
+
+Symbol* Scope::lookup(uint32_t id) {
+    // This scope first, then the enclosing ones
+    for (Scope* scope = this; scope; scope = scope->parent) {
+        if (Symbol* symbol = scope->symbolIndex.find(id)) {
+            return symbol;
+        }
     }
-    
     return nullptr;
 }
 
@@ -168,7 +267,7 @@ std::string Scope::toString() const {
     std::stringstream ss;
     
     // Basic scope info
-    ss << "Scope: " << name << " (";
+    ss << "Scope: " << getName() << " (";
     
     // Type info
     switch (type) {
@@ -186,7 +285,7 @@ std::string Scope::toString() const {
     ss << ")";
     
     // Location
-    ss << " at " << filename << ":" << startLine << ":" << startColumn;
+    ss << " at " << getFilename() << ":" << startLine << ":" << startColumn;
     if (endLine != -1) {
         ss << " to " << endLine << ":" << endColumn;
     }
@@ -198,10 +297,11 @@ std::string Scope::toString() const {
 }
 
 // SymbolTable implementation
-SymbolTable::SymbolTable() {
+SymbolTable::SymbolTable() : uniqueNames(0) {
     // Create the global scope
-    globalScope = std::make_unique<Scope>("global", ScopeType::GLOBAL, 0, 0, "", nullptr);
-    currentScope = globalScope.get();
+    scopeArena.emplace_back(this, names.intern("global"), ScopeType::GLOBAL, 0, 0, names.intern(""), nullptr);
+    globalScope = &scopeArena.back();
+    currentScope = globalScope;
 }
 
 Scope* SymbolTable::createScope(const std::string& name, ScopeType type, 
@@ -209,9 +309,10 @@ Scope* SymbolTable::createScope(const std::string& name, ScopeType type,
                                const std::string& filename, Scope* parent) {
     if (!parent) {
         // Create a new file scope
-        auto scope = std::make_unique<Scope>(name, type, startLine, startColumn, filename, globalScope.get());
-        Scope* scopePtr = scope.get();
-        globalScope->getChildren().push_back(std::move(scope));
+        scopeArena.emplace_back(this, names.intern(name), type, startLine, startColumn,
+                                names.intern(filename), globalScope);
+        Scope* scopePtr = &scopeArena.back();
+        globalScope->children.push_back(scopePtr);
         return scopePtr;
     } else {
         // Create a child scope under the specified parent
@@ -221,18 +322,31 @@ Scope* SymbolTable::createScope(const std::string& name, ScopeType type,
 
 void SymbolTable::registerSymbol(Symbol* symbol) {
     if (symbol) {
-        symbolsByName[symbol->getName()].push_back(symbol);
+        uint32_t id = symbol->getNameId();
+        if (id >= symbolsByName.size()) {
+            symbolsByName.resize(names.size());
+        }
+        if (symbolsByName[id].empty()) {
+            ++uniqueNames;
+            nameOrder.push_back(id);
+        }
+        symbolsByName[id].push_back(symbol);
     }
 }
 
 std::vector<Symbol*> SymbolTable::findSymbols(const std::string& name) const {
-    auto it = symbolsByName.find(name);
-    if (it != symbolsByName.end()) {
-        return it->second;
+    uint32_t id = names.find(name);
+    if (id != NamePool::NONE && id < symbolsByName.size()) {
+        return symbolsByName[id];
     }
     return {};
 }
 
+const std::vector<Symbol*>& SymbolTable::findSymbols(uint32_t nameId) const {
+    static const std::vector<Symbol*> none;
+    return nameId < symbolsByName.size() ? symbolsByName[nameId] : none;
+}
+
 Symbol* SymbolTable::addSymbol(const std::string& name, SymbolKind kind, const std::string& type, 
                               int line, int column, bool isDefined) {
     if (currentScope) {
@@ -246,7 +360,7 @@ Symbol* SymbolTable::addSymbol(const std::string& name, SymbolKind kind, const s
 std::string SymbolTable::toString() const {
     std::stringstream ss;
     
-    ss << "Symbol Table: " << symbolsByName.size() << " unique symbols\n";
+    ss << "Symbol Table: " << uniqueNames << " unique symbols\n";
     ss << globalScope->toString() << "\n";
     
     // We could recursively print all scopes and symbols here
@@ -2,9 +2,12 @@
 #define SYMBOL_TABLE_H
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
+#include <deque>
 #include <memory>
+#include <cstdint>
 
 // Symbol kinds
 enum class SymbolKind {
@@ -40,95 +43,164 @@ enum class ScopeType {
 // Forward declarations
 class Scope;
 class Symbol;
+class SymbolTable;
 
-// Symbol class - represents a single symbol in the code
+// Interned strings: every distinct name, type or filename is stored once
+// and referred to by a dense 32-bit id. Strings live in a deque so the
+// views used as map keys stay valid as the pool grows.
+class NamePool {
+private:
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, uint32_t> ids;
+    
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    
+    NamePool();
+    NamePool(const NamePool&) = delete;
+    NamePool& operator=(const NamePool&) = delete;
+    
+    // Id of name, adding it if it is new; the empty string is id 0
+    uint32_t intern(std::string_view name);
+    
+    // Id of name, or NONE if it was never interned
+    uint32_t find(std::string_view name) const;
+    
+    const std::string& name(uint32_t id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+};
+
+// Open-addressing map from name id to symbol with linear probing. Keys
+// and values sit in one array, so a lookup touches a single cache line in
+// the common case.
+class SymbolIdMap {
+private:
+    struct Slot {
+        uint32_t key;
+        Symbol* value;
+    };
+    std::vector<Slot> slots;
+    size_t count;
+    
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+    
+    size_t slotFor(uint32_t key) const;
+    void grow();
+    
+public:
+    SymbolIdMap() : count(0) {}
+    
+    Symbol* find(uint32_t key) const;
+    
+    // Insert or replace
+    void insert(uint32_t key, Symbol* value);
+    
+    size_t size() const { return count; }
+};
+
+// Symbol class - represents a single symbol in the code. Symbols live in
+// the SymbolTable's arena; strings are ids into its NamePool and the
+// attribute flags share one word.
 class Symbol {
 private:
-    std::string name;
-    SymbolKind kind;
-    std::string type;
+    enum Flag : uint16_t {
+        DEFINED = 1 << 0,
+        USED = 1 << 1,
+        STATIC = 1 << 2,
+        CONST = 1 << 3,
+        PUBLIC = 1 << 4,
+        PROTECTED = 1 << 5,
+        PRIVATE = 1 << 6,
+        EXPORTED = 1 << 7,
+        IMPORTED = 1 << 8
+    };
+    
+    NamePool* names;
+    Scope* scope; // Parent scope
+    uint32_t nameId;
+    uint32_t typeId;
+    uint32_t filenameId;
     int line;
     int column;
-    std::string filename;
-    bool isDefined;
-    bool isUsed;
-    Scope* scope; // Parent scope
-
-    // Symbol attributes
-    bool isStatic;
-    bool isConst;
-    bool isPublic;
-    bool isProtected;
-    bool isPrivate;
-    bool isExported;
-    bool isImported;
+    SymbolKind kind;
+    uint16_t flags;
+    
+    bool hasFlag(Flag flag) const { return (flags & flag) != 0; }
+    void setFlag(Flag flag, bool value) { flags = value ? (flags | flag) : (flags & ~flag); }
     
 public:
-    Symbol(const std::string& name, SymbolKind kind, const std::string& type, 
-           int line, int column, const std::string& filename,
+    Symbol(NamePool* names, uint32_t nameId, SymbolKind kind, uint32_t typeId,
+           int line, int column, uint32_t filenameId,
            bool isDefined = false, Scope* scope = nullptr);
            
     // Accessors
-    const std::string& getName() const { return name; }
+    const std::string& getName() const { return names->name(nameId); }
+    uint32_t getNameId() const { return nameId; }
     SymbolKind getKind() const { return kind; }
-    const std::string& getType() const { return type; }
+    const std::string& getType() const { return names->name(typeId); }
     int getLine() const { return line; }
     int getColumn() const { return column; }
-    const std::string& getFilename() const { return filename; }
-    bool getIsDefined() const { return isDefined; }
-    bool getIsUsed() const { return isUsed; }
+    const std::string& getFilename() const { return names->name(filenameId); }
+    bool getIsDefined() const { return hasFlag(DEFINED); }
+    bool getIsUsed() const { return hasFlag(USED); }
     Scope* getScope() const { return scope; }
     
     // Modifiers
-    void setDefined(bool defined) { isDefined = defined; }
-    void setUsed(bool used) { isUsed = used; }
+    void setDefined(bool defined) { setFlag(DEFINED, defined); }
+    void setUsed(bool used) { setFlag(USED, used); }
     void setScope(Scope* newScope) { scope = newScope; }
-    void setType(const std::string& newType) { type = newType; }
+    void setType(const std::string& newType) { typeId = names->intern(newType); }
     
     // Attribute accessors
-    bool getIsStatic() const { return isStatic; }
-    bool getIsConst() const { return isConst; }
-    bool getIsPublic() const { return isPublic; }
-    bool getIsProtected() const { return isProtected; }
-    bool getIsPrivate() const { return isPrivate; }
-    bool getIsExported() const { return isExported; }
-    bool getIsImported() const { return isImported; }
+    bool getIsStatic() const { return hasFlag(STATIC); }
+    bool getIsConst() const { return hasFlag(CONST); }
+    bool getIsPublic() const { return hasFlag(PUBLIC); }
+    bool getIsProtected() const { return hasFlag(PROTECTED); }
+    bool getIsPrivate() const { return hasFlag(PRIVATE); }
+    bool getIsExported() const { return hasFlag(EXPORTED); }
+    bool getIsImported() const { return hasFlag(IMPORTED); }
     
     // Attribute modifiers
-    void setIsStatic(bool value) { isStatic = value; }
-    void setIsConst(bool value) { isConst = value; }
-    void setIsPublic(bool value) { isPublic = value; }
-    void setIsProtected(bool value) { isProtected = value; }
-    void setIsPrivate(bool value) { isPrivate = value; }
-    void setIsExported(bool value) { isExported = value; }
-    void setIsImported(bool value) { isImported = value; }
+    void setIsStatic(bool value) { setFlag(STATIC, value); }
+    void setIsConst(bool value) { setFlag(CONST, value); }
+    void setIsPublic(bool value) { setFlag(PUBLIC, value); }
+    void setIsProtected(bool value) { setFlag(PROTECTED, value); }
+    void setIsPrivate(bool value) { setFlag(PRIVATE, value); }
+    void setIsExported(bool value) { setFlag(EXPORTED, value); }
+    void setIsImported(bool value) { setFlag(IMPORTED, value); }
     
     // String representation
     std::string toString() const;
 };
 
-// Scope class - represents a lexical scope in the code
+// Scope class - represents a lexical scope in the code. Scopes are owned by
+// the SymbolTable's arena; a scope lists its symbols in declaration order
+// and finds them by name id through an open-addressing map.
 class Scope {
 private:
-    std::string name;
+    SymbolTable* table;
+    uint32_t nameId;
     ScopeType type;
     int startLine;
     int startColumn;
     int endLine;
     int endColumn;
-    std::string filename;
+    uint32_t filenameId;
     
     // Parent-child relationships
     Scope* parent;
-    std::vector<std::unique_ptr<Scope>> children;
+    std::vector<Scope*> children;
     
     // Symbols in this scope
-    std::unordered_map<std::string, std::unique_ptr<Symbol>> symbols;
+    std::vector<Symbol*> symbols;
+    SymbolIdMap symbolIndex;
+    
+    friend class SymbolTable;
     
 public:
-    Scope(const std::string& name, ScopeType type, 
+    Scope(SymbolTable* table, uint32_t nameId, ScopeType type, 
           int startLine, int startColumn, 
-          const std::string& filename, Scope* parent = nullptr);
+          uint32_t filenameId, Scope* parent = nullptr);
     
     // Set end position (when scope is closed)
     void setEndPosition(int line, int column) {
@@ -137,46 +209,72 @@ public:
     }
     
     // Accessors
-    const std::string& getName() const { return name; }
+    const std::string& getName() const;
     ScopeType getType() const { return type; }
     int getStartLine() const { return startLine; }
     int getStartColumn() const { return startColumn; }
     int getEndLine() const { return endLine; }
     int getEndColumn() const { return endColumn; }
-    const std::string& getFilename() const { return filename; }
+    const std::string& getFilename() const;
     Scope* getParent() const { return parent; }
     
     // Scope management
     Scope* createChildScope(const std::string& name, ScopeType type, 
                             int startLine, int startColumn);
-    const std::vector<std::unique_ptr<Scope>>& getChildren() const { return children; }
-    std::vector<std::unique_ptr<Scope>>& getChildren() { return children; }
+    // Child in another file than this scope (e.g. a block under the
+    // global scope, which has no file)
+    Scope* createChildScope(const std::string& name, ScopeType type, 
+                            int startLine, int startColumn, const std::string& filename);
+    const std::vector<Scope*>& getChildren() const { return children; }
     
     // Symbol management
     Symbol* addSymbol(const std::string& name, SymbolKind kind, const std::string& type, 
                       int line, int column, bool isDefined = false);
     Symbol* findSymbol(const std::string& name);
     Symbol* findSymbolInScope(const std::string& name) const;
-    const std::unordered_map<std::string, std::unique_ptr<Symbol>>& getSymbols() const { return symbols; }
+    Symbol* findSymbolInScope(uint32_t nameId) const { return symbolIndex.find(nameId); }
+    const std::vector<Symbol*>& getSymbols() const { return symbols; }
     
     // Symbol lookup through scope hierarchy
     Symbol* lookup(const std::string& name);
+    Symbol* lookup(uint32_t nameId);
     
     // String representation
     std::string toString() const;
 };
 
-// SymbolTable class - main container for all symbol information
+// SymbolTable class - main container for all symbol information. Symbols
+// and scopes are allocated from deques, which keep them in large
+// contiguous blocks without moving them as the table grows.
 class SymbolTable {
 private:
-    std::unique_ptr<Scope> globalScope;
-    std::unordered_map<std::string, std::vector<Symbol*>> symbolsByName;
+    NamePool names;
+    std::deque<Symbol> symbolArena;
+    std::deque<Scope> scopeArena;
+    Scope* globalScope;
+    
+    // Symbols by name id, in registration order
+    std::vector<std::vector<Symbol*>> symbolsByName;
+    size_t uniqueNames;
+    
+    // Name ids in the order their first symbol was registered
+    std::vector<uint32_t> nameOrder;
+    
+    friend class Scope;
     
 public:
     SymbolTable();
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+    
+    NamePool& getNames() { return names; }
+    const NamePool& getNames() const { return names; }
+    size_t symbolCount() const { return symbolArena.size(); }
+    const Symbol& symbolAt(size_t index) const { return symbolArena[index]; }
+    size_t scopeCount() const { return scopeArena.size(); }
     
     // Scope management
-    Scope* getGlobalScope() const { return globalScope.get(); }
+    Scope* getGlobalScope() const { return globalScope; }
     Scope* createScope(const std::string& name, ScopeType type, 
                       int startLine, int startColumn, 
                       const std::string& filename, Scope* parent = nullptr);
@@ -184,6 +282,11 @@ public:
     // Symbol management
     void registerSymbol(Symbol* symbol);
     std::vector<Symbol*> findSymbols(const std::string& name) const;
+    const std::vector<Symbol*>& findSymbols(uint32_t nameId) const;
+    
+    // Ids of the names that have symbols, in the order they first appeared;
+    // only ever appended to, so indexes can catch up incrementally
+    const std::vector<uint32_t>& getSymbolNames() const { return nameOrder; }
     
     // Scope tracking for parsing
     Scope* currentScope;
@@ -202,4 +305,4 @@ public:
     std::string toString() const;
 };
 
-#endif // SYMBOL_TABLE_H 
\ No newline at end of file
+#endif // SYMBOL_TABLE_H
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "SymbolTableBuilder.h"
+#include "BracketIndex.h"
+
+bool parseSymbolMode(const std::string& name, SymbolMode& mode) {
+    if (name == "off") {
+        mode = SymbolMode::OFF;
+    } else if (name == "inline") {
+        mode = SymbolMode::INLINE;
+    } else if (name == "deferred") {
+        mode = SymbolMode::DEFERRED;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+SymbolTableBuilder::SymbolTableBuilder(std::shared_ptr<SymbolTable> table, const LanguageConfig& config)
+    : table(table ? std::move(table) : std::make_shared<SymbolTable>()), keywordSets(config.keywordSets) {}
+
+Symbol* SymbolTableBuilder::add(const Token& token) {
+    if (token.type == TokenType::IDENTIFIER) {
+        if (!isReservedWord(keywordSets, token.lexeme)) {
+            return recordIdentifier(*table, token.lexeme, token.location.line, token.location.column);
+        }
+    } else {
+        trackScope(*table, token);
+    }
+    return nullptr;
+}
+
+void SymbolTableBuilder::build(const std::vector<Token>& tokens) {
+    for (const auto& token : tokens) {
+        add(token);
+    }
+}
+
+std::future<void> SymbolTableBuilder::buildAsync(const std::vector<Token>& tokens) {
+    return std::async(std::launch::async, [this, &tokens]() { build(tokens); });
+}
+
+bool SymbolTableBuilder::isReservedWord(const KeywordSets& keywordSets, const std::string& lexeme) {
+    return keywordSets.keywords.count(lexeme) > 0 || keywordSets.types.count(lexeme) > 0 ||
+           keywordSets.builtins.count(lexeme) > 0;
+}
+
+Symbol* SymbolTableBuilder::recordIdentifier(SymbolTable& table, const std::string& lexeme, int line, int column) {
+    Symbol* symbol = table.currentScope->lookup(lexeme);
+    
+    if (!symbol) {
+        // New identifier, create symbol
+        symbol = table.addSymbol(lexeme, SymbolKind::UNKNOWN, "", line, column);
+    } else {
+        // Mark as used
+        symbol->setUsed(true);
+    }
+    return symbol;
+}
+
+void SymbolTableBuilder::trackScope(SymbolTable& table, const Token& token) {
+    if (!BracketIndex::isBracket(token)) {
+        return;
+    }
+    
+    // Braces open and close block scopes. The global scope has no file, so
+    // top-level blocks take the token's; nested ones inherit it.
+    if (token.lexeme[0] == '{') {
+        Scope* block = table.currentScope == table.getGlobalScope()
+            ? table.currentScope->createChildScope("block", ScopeType::BLOCK, token.location.line,
+                                                   token.location.column, token.location.filename)
+            : table.currentScope->createChildScope("block", ScopeType::BLOCK, token.location.line,
+                                                   token.location.column);
+        table.enterScope(block);
+    } else if (token.lexeme[0] == '}' && table.currentScope != table.getGlobalScope()) {
+        table.currentScope->setEndPosition(token.location.line, token.location.column);
+        table.exitScope();
+    }
+}
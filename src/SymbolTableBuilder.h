@@ -0,0 +1,53 @@
+#ifndef SYMBOL_TABLE_BUILDER_H
+#define SYMBOL_TABLE_BUILDER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <future>
+#include "Token.h"
+#include "LanguageConfig.h"
+#include "SymbolTable.h"
+
+// When the lexer fills its symbol table
+enum class SymbolMode {
+    OFF,      // never; identifiers carry no symbol information
+    INLINE,   // while scanning, attaching an IdentifierAttribute where it can
+    DEFERRED  // not while lexing; run a SymbolTableBuilder over the tokens
+};
+
+// Parse "off", "inline" or "deferred"
+bool parseSymbolMode(const std::string& name, SymbolMode& mode);
+
+// Fills a symbol table from tokens: braces open and close block scopes,
+// identifiers that are not reserved words are recorded in the current
+// scope. The lexer applies the same rules inline; deferred, they run in a
+// separate pass over the token buffer, possibly on another thread.
+// Deferred builds see only the tokens the filter let through and do not
+// attach attributes to them.
+class SymbolTableBuilder {
+private:
+    std::shared_ptr<SymbolTable> table;
+    KeywordSets keywordSets;
+
+public:
+    SymbolTableBuilder(std::shared_ptr<SymbolTable> table, const LanguageConfig& config);
+
+    std::shared_ptr<SymbolTable> getSymbolTable() const { return table; }
+
+    // Returns the symbol an identifier was recorded as, or nullptr; the
+    // symbol's position is the token's when this is its declaration
+    Symbol* add(const Token& token);
+    void build(const std::vector<Token>& tokens);
+
+    // Build on another thread; tokens and the builder must stay alive
+    // until the future is ready
+    std::future<void> buildAsync(const std::vector<Token>& tokens);
+
+    // The rules, shared with the lexer's inline mode
+    static bool isReservedWord(const KeywordSets& keywordSets, const std::string& lexeme);
+    static Symbol* recordIdentifier(SymbolTable& table, const std::string& lexeme, int line, int column);
+    static void trackScope(SymbolTable& table, const Token& token);
+};
+
+#endif // SYMBOL_TABLE_BUILDER_H
@@ -0,0 +1,287 @@
+#include "TagFile.h"
+#include "Lexer.h"
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Approximate heap footprint of a tag, for the memory limit
+size_t footprint(const TagEntry& tag) {
+    return sizeof(TagEntry) + tag.name.capacity() + tag.text.capacity();
+}
+
+bool tagOrder(TagFormat format, const TagEntry& a, const TagEntry& b) {
+    if (format == TagFormat::ETAGS) {
+        if (a.file != b.file) return a.file < b.file;
+        if (a.line != b.line) return a.line < b.line;
+        if (a.column != b.column) return a.column < b.column;
+        return a.name < b.name;
+    }
+    int names = a.name.compare(b.name);
+    if (names != 0) return names < 0;
+    if (a.file != b.file) return a.file < b.file;
+    if (a.line != b.line) return a.line < b.line;
+    return a.kind < b.kind;
+}
+
+// Run files hold one tag per line: name, file, line, column, kind, offset
+// and text, separated by tabs (only the text can contain one, so it comes
+// last)
+void writeRunEntry(std::ostream& out, const TagEntry& tag) {
+    out << tag.name << '\t' << tag.file << '\t' << tag.line << '\t' << tag.column << '\t'
+        << (tag.kind ? tag.kind : '-') << '\t' << tag.offset << '\t' << tag.text << '\n';
+}
+
+bool readRunEntry(std::istream& in, TagEntry& tag) {
+    std::string line;
+    if (!std::getline(in, line)) {
+        return false;
+    }
+    size_t fields[6];
+    size_t position = 0;
+    for (size_t& field : fields) {
+        field = line.find('\t', position);
+        if (field == std::string::npos) {
+            return false;
+        }
+        position = field + 1;
+    }
+    tag.name = line.substr(0, fields[0]);
+    tag.file = static_cast<uint32_t>(std::stoul(line.substr(fields[0] + 1, fields[1] - fields[0] - 1)));
+    tag.line = static_cast<uint32_t>(std::stoul(line.substr(fields[1] + 1, fields[2] - fields[1] - 1)));
+    tag.column = static_cast<uint32_t>(std::stoul(line.substr(fields[2] + 1, fields[3] - fields[2] - 1)));
+    tag.kind = line[fields[3] + 1] == '-' ? 0 : line[fields[3] + 1];
+    tag.offset = std::stoull(line.substr(fields[4] + 1, fields[5] - fields[4] - 1));
+    tag.text = line.substr(fields[5] + 1);
+    return true;
+}
+
+// A sorted run being merged, from memory or from a run file
+class RunCursor {
+private:
+    const std::vector<TagEntry>* memory;
+    size_t index;
+    std::ifstream in;
+    TagEntry entry;
+    bool valid;
+
+public:
+    explicit RunCursor(const std::vector<TagEntry>& run) : memory(&run), index(0), valid(!run.empty()) {}
+
+    explicit RunCursor(const std::string& path) : memory(nullptr), index(0), in(path), valid(false) {
+        valid = readRunEntry(in, entry);
+    }
+
+    bool isValid() const { return valid; }
+    const TagEntry& current() const { return memory ? (*memory)[index] : entry; }
+
+    void advance() {
+        if (memory) {
+            valid = ++index < memory->size();
+        } else {
+            valid = readRunEntry(in, entry);
+        }
+    }
+};
+
+// K-way merge of sorted runs, calling emit for every tag in order
+template <typename Emit>
+void mergeRuns(TagFormat format, std::vector<std::unique_ptr<RunCursor>>& cursors, Emit emit) {
+    auto later = [&](size_t a, size_t b) { return tagOrder(format, cursors[b]->current(), cursors[a]->current()); };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heap(later);
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        if (cursors[i]->isValid()) {
+            heap.push(i);
+        }
+    }
+    while (!heap.empty()) {
+        size_t next = heap.top();
+        heap.pop();
+        emit(cursors[next]->current());
+        cursors[next]->advance();
+        if (cursors[next]->isValid()) {
+            heap.push(next);
+        }
+    }
+}
+
+} // namespace
+
+char tagKind(SymbolKind kind) {
+    switch (kind) {
+        case SymbolKind::VARIABLE: return 'v';
+        case SymbolKind::FUNCTION: return 'f';
+        case SymbolKind::CLASS: return 'c';
+        case SymbolKind::STRUCT: return 's';
+        case SymbolKind::ENUM: return 'g';
+        case SymbolKind::TYPEDEF: return 't';
+        case SymbolKind::NAMESPACE: return 'n';
+        case SymbolKind::PARAMETER: return 'z';
+        case SymbolKind::TEMPLATE: return 'T';
+        case SymbolKind::MACRO: return 'd';
+        case SymbolKind::LABEL: return 'l';
+        case SymbolKind::MODULE: return 'm';
+        default: return 0;
+    }
+}
+
+std::vector<TagEntry> collectTags(const std::string& source, const LanguageConfig& config,
+                                  const std::string& filename, uint32_t file, TagFormat format) {
+    auto table = std::make_shared<SymbolTable>();
+    Lexer lexer(source, config, filename);
+    lexer.setSymbolTable(table);
+    lexer.setSymbolMode(SymbolMode::INLINE);
+    lexer.tokenize([](const Token&) {});
+
+    // etags needs each symbol's line; symbols come in source order, so
+    // line starts are found by walking forward
+    size_t lineStart = 0;
+    int currentLine = 1;
+
+    std::vector<TagEntry> tags;
+    tags.reserve(table->symbolCount());
+    for (size_t i = 0; i < table->symbolCount(); ++i) {
+        const Symbol& symbol = table->symbolAt(i);
+        TagEntry tag;
+        tag.name = symbol.getName();
+        tag.file = file;
+        tag.line = static_cast<uint32_t>(std::max(symbol.getLine(), 0));
+        tag.column = static_cast<uint32_t>(std::max(symbol.getColumn(), 0));
+        tag.kind = tagKind(symbol.getKind());
+        tag.offset = 0;
+        if (format == TagFormat::ETAGS) {
+            if (symbol.getLine() < currentLine) {
+                lineStart = 0;
+                currentLine = 1;
+            }
+            while (currentLine < symbol.getLine() && lineStart < source.size()) {
+                const void* newline = std::memchr(source.data() + lineStart, '\n', source.size() - lineStart);
+                if (!newline) {
+                    break;
+                }
+                lineStart = static_cast<const char*>(newline) - source.data() + 1;
+                ++currentLine;
+            }
+            size_t end = std::min(source.size(), lineStart + std::max(symbol.getColumn() - 1, 0) + tag.name.size());
+            size_t newline = source.find('\n', lineStart);
+            tag.offset = lineStart;
+            tag.text = source.substr(lineStart, std::min(end, newline) - lineStart);
+        }
+        tags.push_back(std::move(tag));
+    }
+    return tags;
+}
+
+// TagSorter implementation
+TagSorter::TagSorter(TagFormat format, const std::string& runPrefix, size_t memoryLimit)
+    : format(format), runPrefix(runPrefix), memoryLimit(memoryLimit), memoryUsed(0), runTotal(0), tagTotal(0) {}
+
+TagSorter::~TagSorter() {
+    for (const auto& path : runFiles) {
+        std::remove(path.c_str());
+    }
+}
+
+bool TagSorter::addRun(std::vector<TagEntry> run, std::string& error) {
+    std::sort(run.begin(), run.end(), [this](const TagEntry& a, const TagEntry& b) { return tagOrder(format, a, b); });
+    size_t bytes = 0;
+    for (const auto& tag : run) {
+        bytes += footprint(tag);
+    }
+
+    std::vector<std::vector<TagEntry>> full;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++runTotal;
+        tagTotal += run.size();
+        memoryRuns.push_back(std::move(run));
+        memoryUsed += bytes;
+        if (memoryUsed <= memoryLimit) {
+            return true;
+        }
+        full.swap(memoryRuns);
+        memoryUsed = 0;
+    }
+    // Merge the runs held so far into a file, without holding the lock
+    return spill(std::move(full), error);
+}
+
+bool TagSorter::spill(std::vector<std::vector<TagEntry>> runs, std::string& error) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        path = runPrefix + std::to_string(runFiles.size());
+        runFiles.push_back(path);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "could not create " + path;
+        return false;
+    }
+    std::vector<std::unique_ptr<RunCursor>> cursors;
+    for (const auto& run : runs) {
+        cursors.push_back(std::make_unique<RunCursor>(run));
+    }
+    mergeRuns(format, cursors, [&](const TagEntry& tag) { writeRunEntry(out, tag); });
+    if (!out.flush()) {
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool TagSorter::write(std::ostream& out, const std::vector<std::string>& filenames, std::string& error) {
+    std::vector<std::unique_ptr<RunCursor>> cursors;
+    for (const auto& path : runFiles) {
+        cursors.push_back(std::make_unique<RunCursor>(path));
+    }
+    for (const auto& run : memoryRuns) {
+        cursors.push_back(std::make_unique<RunCursor>(run));
+    }
+
+    if (format == TagFormat::CTAGS) {
+        out << "!_TAG_FILE_FORMAT\t2\t/extended format; --format=1 will not append ;\" to lines/\n";
+        out << "!_TAG_FILE_SORTED\t1\t/0=unsorted, 1=sorted, 2=foldcase/\n";
+        out << "!_TAG_PROGRAM_NAME\tlex\t//\n";
+        mergeRuns(format, cursors, [&](const TagEntry& tag) {
+            out << tag.name << '\t' << filenames[tag.file] << '\t' << tag.line << ";\"";
+            if (tag.kind) {
+                out << '\t' << tag.kind;
+            }
+            out << '\n';
+        });
+    } else {
+        // Each file's section is preceded by its size in bytes
+        std::string section;
+        uint32_t sectionFile = 0;
+        auto flushSection = [&]() {
+            if (!section.empty()) {
+                out << "\f\n" << filenames[sectionFile] << ',' << section.size() << '\n' << section;
+                section.clear();
+            }
+        };
+        mergeRuns(format, cursors, [&](const TagEntry& tag) {
+            if (tag.file != sectionFile) {
+                flushSection();
+                sectionFile = tag.file;
+            }
+            section += tag.text;
+            section += '\x7f';
+            section += tag.name;
+            section += '\x01';
+            section += std::to_string(tag.line) + "," + std::to_string(tag.offset) + "\n";
+        });
+        flushSection();
+    }
+
+    if (!out.flush()) {
+        error = "could not write the tag file";
+        return false;
+    }
+    return true;
+}
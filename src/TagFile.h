@@ -0,0 +1,78 @@
+#ifndef TAG_FILE_H
+#define TAG_FILE_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <ostream>
+#include <cstdint>
+#include "LanguageConfig.h"
+#include "SymbolTable.h"
+
+// Tag file flavours: vi-style ctags ("tags", sorted by name) and Emacs
+// etags ("TAGS", grouped by file)
+enum class TagFormat {
+    CTAGS,
+    ETAGS
+};
+
+// One symbol to tag. text and offset, the line up to the name and the
+// byte offset of its start, are only filled for etags.
+struct TagEntry {
+    std::string name;
+    uint32_t file;
+    uint32_t line;
+    uint32_t column;
+    char kind;
+    uint64_t offset;
+    std::string text;
+};
+
+// ctags kind letter for a symbol kind, or 0 for none
+char tagKind(SymbolKind kind);
+
+// Lex a file and return a tag for every symbol its symbol table records
+std::vector<TagEntry> collectTags(const std::string& source, const LanguageConfig& config,
+                                  const std::string& filename, uint32_t file, TagFormat format);
+
+// External merge sort of tag runs. Workers sort their runs and hand them
+// over; runs are kept in memory until they exceed the memory limit, then
+// the worker that crossed it merges them into a run file next to the
+// output. write() k-way merges what is left in memory with the run files.
+// Tags are ordered by name, file id and line for ctags and by file id and
+// line for etags, so the output does not depend on how runs were formed.
+class TagSorter {
+private:
+    TagFormat format;
+    std::string runPrefix;
+    size_t memoryLimit;
+
+    std::mutex mutex;
+    std::vector<std::vector<TagEntry>> memoryRuns;
+    size_t memoryUsed;
+    std::vector<std::string> runFiles;
+    size_t runTotal;
+    size_t tagTotal;
+
+    bool spill(std::vector<std::vector<TagEntry>> runs, std::string& error);
+
+public:
+    // Run files are named runPrefix + number
+    TagSorter(TagFormat format, const std::string& runPrefix, size_t memoryLimit);
+    ~TagSorter();
+
+    TagSorter(const TagSorter&) = delete;
+    TagSorter& operator=(const TagSorter&) = delete;
+
+    // Sort a run and add it; safe to call from several threads
+    bool addRun(std::vector<TagEntry> run, std::string& error);
+
+    // Merge every run into the tag file; filenames are indexed by file id
+    bool write(std::ostream& out, const std::vector<std::string>& filenames, std::string& error);
+
+    size_t runCount() const { return runTotal; }
+    size_t spilledCount() const { return runFiles.size(); }
+    size_t tagCount() const { return tagTotal; }
+};
+
+#endif // TAG_FILE_H
@@ -0,0 +1,119 @@
+#include "TeeWriter.h"
+
+// TeeWriter implementation
+TeeWriter::TeeWriter(OutputSink& placeholder, std::vector<std::unique_ptr<TokenWriter>> writers)
+    : TokenWriter(placeholder), writers(std::move(writers)), results(this->writers.size(), false) {}
+
+std::unique_ptr<TeeWriter> TeeWriter::create(std::vector<std::unique_ptr<TokenWriter>> writers) {
+    auto placeholder = std::make_unique<NullSink>();
+    auto tee = std::make_unique<TeeWriter>(*placeholder, std::move(writers));
+    tee->adoptSink(std::move(placeholder));
+    return tee;
+}
+
+void TeeWriter::writeHeader() {
+    for (auto& writer : writers) {
+        writer->begin();
+    }
+}
+
+void TeeWriter::writeToken(const Token& token) {
+    for (auto& writer : writers) {
+        writer->write(token);
+    }
+}
+
+void TeeWriter::writeFooter() {
+    for (size_t i = 0; i < writers.size(); ++i) {
+        results[i] = writers[i]->finish();
+        if (!results[i]) {
+            failed = true;
+        }
+    }
+}
+
+// AsyncTokenWriter implementation
+AsyncTokenWriter::AsyncTokenWriter(OutputSink& placeholder, std::unique_ptr<TokenWriter> inner,
+                                   size_t batchSize, size_t maxQueuedBatches)
+    : TokenWriter(placeholder), inner(std::move(inner)), batchSize(batchSize > 0 ? batchSize : 1),
+      maxQueuedBatches(maxQueuedBatches > 0 ? maxQueuedBatches : 1), closing(false) {
+    batch.reserve(this->batchSize);
+}
+
+AsyncTokenWriter::~AsyncTokenWriter() {
+    stop();
+}
+
+std::unique_ptr<AsyncTokenWriter> AsyncTokenWriter::create(std::unique_ptr<TokenWriter> inner) {
+    auto placeholder = std::make_unique<NullSink>();
+    auto writer = std::make_unique<AsyncTokenWriter>(*placeholder, std::move(inner));
+    writer->adoptSink(std::move(placeholder));
+    return writer;
+}
+
+void AsyncTokenWriter::run() {
+    for (;;) {
+        std::vector<Token> tokens;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [this] { return closing || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            tokens = std::move(queue.front());
+            queue.pop_front();
+        }
+        notFull.notify_one();
+
+        for (const auto& token : tokens) {
+            inner->write(token);
+        }
+    }
+}
+
+void AsyncTokenWriter::pushBatch() {
+    if (batch.empty()) {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return queue.size() < maxQueuedBatches; });
+        queue.push_back(std::move(batch));
+    }
+    notEmpty.notify_one();
+
+    batch = std::vector<Token>();
+    batch.reserve(batchSize);
+}
+
+void AsyncTokenWriter::stop() {
+    if (!worker.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    notEmpty.notify_one();
+    worker.join();
+}
+
+void AsyncTokenWriter::writeHeader() {
+    inner->begin();
+    worker = std::thread(&AsyncTokenWriter::run, this);
+}
+
+void AsyncTokenWriter::writeToken(const Token& token) {
+    batch.push_back(token);
+    if (batch.size() >= batchSize) {
+        pushBatch();
+    }
+}
+
+void AsyncTokenWriter::writeFooter() {
+    pushBatch();
+    stop();
+    if (!inner->finish()) {
+        failed = true;
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef TEE_WRITER_H
+#define TEE_WRITER_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Token.h"
+#include "ExportFormatter.h"
+
+// Feeds one token stream to several writers, so a single lexing pass can
+// produce e.g. JSON, CSV and HTML at once.
+class TeeWriter : public TokenWriter {
+private:
+    std::vector<std::unique_ptr<TokenWriter>> writers;
+    std::vector<bool> results;
+
+protected:
+    void writeHeader() override;
+    void writeToken(const Token& token) override;
+    void writeFooter() override;
+
+public:
+    TeeWriter(OutputSink& placeholder, std::vector<std::unique_ptr<TokenWriter>> writers);
+
+    // Build a tee over already opened writers
+    static std::unique_ptr<TeeWriter> create(std::vector<std::unique_ptr<TokenWriter>> writers);
+
+    size_t size() const { return writers.size(); }
+
+    // Whether writer i finished successfully (valid after finish())
+    bool succeeded(size_t index) const { return results[index]; }
+};
+
+// Runs another writer on its own thread. Tokens are copied into batches
+// and handed over through a bounded queue, so formatting and writing
+// overlap with lexing without unbounded buffering.
+class AsyncTokenWriter : public TokenWriter {
+private:
+    std::unique_ptr<TokenWriter> inner;
+    size_t batchSize;
+    size_t maxQueuedBatches;
+
+    std::vector<Token> batch;
+    std::deque<std::vector<Token>> queue;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    bool closing;
+    std::thread worker;
+
+    void run();
+    void pushBatch();
+    void stop();
+
+protected:
+    void writeHeader() override;
+    void writeToken(const Token& token) override;
+    void writeFooter() override;
+
+public:
+    static constexpr size_t DEFAULT_BATCH_SIZE = 4096;
+    static constexpr size_t DEFAULT_QUEUED_BATCHES = 8;
+
+    AsyncTokenWriter(OutputSink& placeholder, std::unique_ptr<TokenWriter> inner,
+                     size_t batchSize = DEFAULT_BATCH_SIZE,
+                     size_t maxQueuedBatches = DEFAULT_QUEUED_BATCHES);
+    ~AsyncTokenWriter() override;
+
+    static std::unique_ptr<AsyncTokenWriter> create(std::unique_ptr<TokenWriter> inner);
+};
+
+#endif // TEE_WRITER_H
@@ -0,0 +1,102 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threads)
+    : task(nullptr), taskCount(0), nextIndex(0), pendingWorkers(0), generation(0), stopping(false) {
+    if (threads == 0) {
+        threads = hardwareThreads();
+    }
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::hardwareThreads() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+void ThreadPool::runTasks() {
+    for (;;) {
+        size_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+        if (index >= taskCount) {
+            return;
+        }
+        try {
+            (*task)(index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        runTasks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pendingWorkers == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    if (workers.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &fn;
+        taskCount = count;
+        nextIndex.store(0, std::memory_order_relaxed);
+        pendingWorkers = workers.size();
+        failure = nullptr;
+        ++generation;
+    }
+    wake.notify_all();
+
+    runTasks();
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return pendingWorkers == 0; });
+        task = nullptr;
+        error = failure;
+        failure = nullptr;
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
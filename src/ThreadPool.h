@@ -0,0 +1,52 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed set of worker threads for data-parallel loops. parallelFor() hands
+// out indices dynamically; the calling thread works too and the call
+// returns once every index has been processed.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(size_t)>* task;
+    size_t taskCount;
+    std::atomic<size_t> nextIndex;
+    size_t pendingWorkers;
+    uint64_t generation;
+    bool stopping;
+    std::exception_ptr failure;
+
+    void workerLoop();
+    void runTasks();
+
+public:
+    // threads is the total parallelism including the caller; 0 picks the
+    // number of hardware threads
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    // Call fn(i) for every i in [0, count); rethrows the first exception
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    static size_t hardwareThreads();
+};
+
+#endif // THREAD_POOL_H
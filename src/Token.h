@@ -10,9 +10,10 @@ struct SourceLocation {
     int line;
     int column;
     std::string filename;
+    size_t offset; // Byte offset of the token's start in the source
     
-    SourceLocation(int line = 0, int column = 0, const std::string& filename = "")
-        : line(line), column(column), filename(filename) {}
+    SourceLocation(int line = 0, int column = 0, const std::string& filename = "", size_t offset = 0)
+        : line(line), column(column), filename(filename), offset(offset) {}
     
     std::string toString() const {
         return filename + ":" + std::to_string(line) + ":" + std::to_string(column);
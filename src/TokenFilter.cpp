@@ -0,0 +1,131 @@
+#include "TokenFilter.h"
+#include <cctype>
+
+bool parseTokenType(const std::string& name, TokenType& type) {
+    std::string upper;
+    for (char c : name) {
+        upper += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+
+    for (int value = 0; value <= static_cast<int>(TokenType::UNKNOWN); ++value) {
+        TokenType candidate = static_cast<TokenType>(value);
+        if (Token(candidate, "", 0, 0).typeToString() == upper) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// TokenFilter implementation
+TokenFilter::TokenFilter() : droppedTypes(0), dropBlankTokens(false) {}
+
+void TokenFilter::drop(TokenType type) {
+    droppedTypes |= bit(type);
+}
+
+void TokenFilter::keep(TokenType type) {
+    droppedTypes &= ~bit(type);
+}
+
+void TokenFilter::keepOnly(const std::vector<TokenType>& types) {
+    droppedTypes = bit(TokenType::UNKNOWN) | (bit(TokenType::UNKNOWN) - 1);
+    for (TokenType type : types) {
+        keep(type);
+    }
+}
+
+bool TokenFilter::accepts(const Token& token) const {
+    if (token.type == TokenType::EOF_TOKEN) {
+        return true;
+    }
+    if (drops(token.type)) {
+        return false;
+    }
+    if (dropBlankTokens) {
+        bool blank = true;
+        for (char c : token.lexeme) {
+            if (!std::isspace(static_cast<unsigned char>(c))) {
+                blank = false;
+                break;
+            }
+        }
+        if (blank) {
+            return false;
+        }
+    }
+    return !predicate || predicate(token);
+}
+
+bool TokenFilter::parseTypes(const std::string& list, std::vector<TokenType>& types) {
+    std::vector<TokenType> parsed;
+    size_t start = 0;
+
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        std::string name = list.substr(start, end - start);
+
+        TokenType type;
+        if (name == "numbers") {
+            parsed.insert(parsed.end(), {TokenType::INTEGER, TokenType::FLOAT, TokenType::HEX,
+                                         TokenType::OCTAL, TokenType::BINARY, TokenType::SCIENTIFIC});
+        } else if (name == "strings") {
+            parsed.insert(parsed.end(), {TokenType::STRING_LITERAL, TokenType::CHAR_LITERAL});
+        } else if (name == "operators") {
+            parsed.insert(parsed.end(), {TokenType::OPERATOR, TokenType::ASSIGNMENT_OPERATOR,
+                                         TokenType::ARITHMETIC_OPERATOR, TokenType::LOGICAL_OPERATOR,
+                                         TokenType::BITWISE_OPERATOR, TokenType::COMPARISON_OPERATOR});
+        } else if (name == "delimiters") {
+            parsed.insert(parsed.end(), {TokenType::DELIMITER, TokenType::PARENTHESIS, TokenType::BRACKET,
+                                         TokenType::BRACE, TokenType::SEMICOLON, TokenType::COMMA,
+                                         TokenType::DOT});
+        } else if (name == "comments") {
+            parsed.push_back(TokenType::COMMENT);
+        } else if (name == "identifiers") {
+            parsed.push_back(TokenType::IDENTIFIER);
+        } else if (parseTokenType(name, type) && type != TokenType::EOF_TOKEN) {
+            parsed.push_back(type);
+        } else {
+            return false;
+        }
+        start = end + 1;
+    }
+
+    types = parsed;
+    return true;
+}
+
+bool TokenFilter::parse(const std::string& list, TokenFilter& filter) {
+    TokenFilter parsed;
+    std::string typeList;
+    size_t start = 0;
+
+    // "blank" is not a type; everything else is a type list entry
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        std::string name = list.substr(start, end - start);
+        if (name == "blank") {
+            parsed.dropBlank();
+        } else {
+            typeList += typeList.empty() ? name : "," + name;
+        }
+        start = end + 1;
+    }
+
+    std::vector<TokenType> types;
+    if (!typeList.empty() && !parseTypes(typeList, types)) {
+        return false;
+    }
+    for (TokenType type : types) {
+        parsed.drop(type);
+    }
+
+    filter = parsed;
+    return true;
+}
@@ -0,0 +1,56 @@
+#ifndef TOKEN_FILTER_H
+#define TOKEN_FILTER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include "Token.h"
+
+// Parse a token type name as printed by Token::typeToString (any case)
+bool parseTokenType(const std::string& name, TokenType& type);
+
+// Decides which tokens the lexer hands out. Dropped comments and
+// preprocessor directives are skipped at scan time without building their
+// text; other tokens are tested once scanned. EOF is never dropped.
+class TokenFilter {
+private:
+    uint64_t droppedTypes;
+    bool dropBlankTokens;
+    std::function<bool(const Token&)> predicate;
+
+    static uint64_t bit(TokenType type) { return uint64_t(1) << static_cast<unsigned>(type); }
+
+public:
+    TokenFilter();
+
+    void drop(TokenType type);
+    void keep(TokenType type);
+
+    // Drop every type except the given ones
+    void keepOnly(const std::vector<TokenType>& types);
+
+    // Drop tokens whose lexeme is empty or only whitespace
+    void dropBlank(bool enable = true) { dropBlankTokens = enable; }
+
+    // Extra test for tokens that pass the type mask; false drops the token
+    void setPredicate(std::function<bool(const Token&)> keepToken) { predicate = std::move(keepToken); }
+
+    bool drops(TokenType type) const {
+        return type != TokenType::EOF_TOKEN && (droppedTypes & bit(type)) != 0;
+    }
+
+    // True if the filter lets every token through
+    bool isEmpty() const { return droppedTypes == 0 && !dropBlankTokens && !predicate; }
+
+    bool accepts(const Token& token) const;
+
+    // Parse a comma-separated list of type names or the groups "numbers",
+    // "strings", "comments", "identifiers", "operators" and "delimiters"
+    static bool parseTypes(const std::string& list, std::vector<TokenType>& types);
+
+    // Parse a type list (plus "blank") into a filter dropping those tokens
+    static bool parse(const std::string& list, TokenFilter& filter);
+};
+
+#endif // TOKEN_FILTER_H
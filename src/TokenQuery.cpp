@@ -0,0 +1,235 @@
+#include "TokenQuery.h"
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+namespace {
+
+const size_t NONE = std::numeric_limits<size_t>::max();
+
+// Longest gap accepted by *{m,n}; every optional token is a state
+const size_t MAX_GAP = 256;
+
+// Strip the quotes and escapes of a quoted lexeme; bare text is kept as is
+std::string unquote(const std::string& text) {
+    if (text.size() < 2 || (text[0] != '\'' && text[0] != '"') || text.back() != text[0]) {
+        return text;
+    }
+    std::string result;
+    for (size_t i = 1; i + 1 < text.size(); ++i) {
+        if (text[i] == '\\' && i + 2 < text.size()) {
+            ++i;
+        }
+        result += text[i];
+    }
+    return result;
+}
+
+bool parseCount(const std::string& text, size_t& count) {
+    if (text.empty() || text.size() > 6 ||
+        !std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        return false;
+    }
+    count = std::stoul(text);
+    return true;
+}
+
+} // namespace
+
+bool TokenQuery::Step::matches(const Token& token) const {
+    if (token.type == TokenType::EOF_TOKEN) {
+        return false;
+    }
+    return (anyType || !types.drops(token.type)) && (anyLexeme || token.lexeme == lexeme);
+}
+
+bool TokenQuery::parse(const std::string& query, TokenQuery& result, std::string& error) {
+    // Split on whitespace outside quotes
+    std::vector<std::string> elements;
+    size_t i = 0;
+    while (i < query.size()) {
+        if (std::isspace(static_cast<unsigned char>(query[i]))) {
+            ++i;
+            continue;
+        }
+        size_t start = i;
+        while (i < query.size() && !std::isspace(static_cast<unsigned char>(query[i]))) {
+            char quote = query[i++];
+            if (quote != '\'' && quote != '"') {
+                continue;
+            }
+            while (i < query.size() && query[i] != quote) {
+                i += query[i] == '\\' ? 2 : 1;
+            }
+            if (i >= query.size()) {
+                error = "unterminated quote in " + query.substr(start);
+                return false;
+            }
+            ++i;
+        }
+        elements.push_back(query.substr(start, i - start));
+    }
+
+    std::vector<Step> steps;
+    Step any;
+    any.anyType = true;
+    any.anyLexeme = true;
+    any.optional = false;
+    any.repeat = false;
+
+    for (const auto& element : elements) {
+        if (element == "_") {
+            steps.push_back(any);
+        } else if (element[0] == '*') {
+            // Gap: * or *{n}, *{m,n}, *{m,}
+            size_t low = 0;
+            size_t high = NONE;
+            if (element.size() > 1) {
+                bool braced = element.size() > 3 && element[1] == '{' && element.back() == '}';
+                std::string inner = braced ? element.substr(2, element.size() - 3) : "";
+                size_t comma = inner.find(',');
+                bool valid = braced && parseCount(inner.substr(0, comma), low);
+                if (valid && comma == std::string::npos) {
+                    high = low;
+                } else if (valid && comma + 1 < inner.size()) {
+                    valid = parseCount(inner.substr(comma + 1), high);
+                }
+                if (!valid || (high != NONE && high < low)) {
+                    error = "invalid gap " + element;
+                    return false;
+                }
+            }
+            if (low > MAX_GAP || (high != NONE && high > MAX_GAP)) {
+                error = "gap " + element + " is too long (at most " + std::to_string(MAX_GAP) + " tokens)";
+                return false;
+            }
+            steps.insert(steps.end(), low, any);
+            Step skip = any;
+            skip.optional = true;
+            if (high == NONE) {
+                skip.repeat = true;
+                steps.push_back(skip);
+            } else {
+                steps.insert(steps.end(), high - low, skip);
+            }
+        } else {
+            Step step = any;
+            std::string typeList;
+            std::string lexeme;
+            if (element[0] == '\'' || element[0] == '"') {
+                lexeme = element;
+            } else {
+                size_t colon = element.find(':');
+                typeList = element.substr(0, colon);
+                if (colon != std::string::npos) {
+                    lexeme = element.substr(colon + 1);
+                    if (lexeme.empty() || typeList.empty()) {
+                        error = "expected TYPE:text in " + element;
+                        return false;
+                    }
+                }
+            }
+
+            if (!typeList.empty() && typeList != "_") {
+                std::replace(typeList.begin(), typeList.end(), '|', ',');
+                std::vector<TokenType> types;
+                if (!TokenFilter::parseTypes(typeList, types)) {
+                    error = "unknown token type in " + element + " (quote text to match it literally)";
+                    return false;
+                }
+                step.types.keepOnly(types);
+                step.anyType = false;
+            }
+            if (!lexeme.empty()) {
+                step.lexeme = unquote(lexeme);
+                step.anyLexeme = false;
+            }
+            steps.push_back(step);
+        }
+    }
+
+    // Optional steps at either end do not change what matches
+    while (!steps.empty() && steps.back().optional) {
+        steps.pop_back();
+    }
+    auto firstRequired = std::find_if(steps.begin(), steps.end(), [](const Step& step) { return !step.optional; });
+    steps.erase(steps.begin(), firstRequired);
+    if (steps.empty()) {
+        error = "query has no token to match";
+        return false;
+    }
+
+    result.steps = std::move(steps);
+    result.text = query;
+    return true;
+}
+
+std::vector<QueryMatch> TokenQuery::findAll(const std::vector<Token>& tokens) const {
+    std::vector<QueryMatch> matches;
+    Matcher matcher(*this);
+    QueryMatch match;
+    for (const auto& token : tokens) {
+        if (matcher.feed(token, match)) {
+            matches.push_back(match);
+        }
+    }
+    return matches;
+}
+
+// Matcher implementation
+TokenQuery::Matcher::Matcher(const TokenQuery& query) : query(query) {
+    reset();
+}
+
+void TokenQuery::Matcher::reset() {
+    starts.assign(query.steps.size() + 1, NONE);
+    next.assign(query.steps.size() + 1, NONE);
+    index = 0;
+    live = 0;
+}
+
+void TokenQuery::Matcher::close(std::vector<size_t>& states) const {
+    for (size_t k = 0; k < query.steps.size(); ++k) {
+        if (states[k] != NONE && query.steps[k].optional) {
+            states[k + 1] = std::min(states[k + 1], states[k]);
+        }
+    }
+}
+
+bool TokenQuery::Matcher::feed(const Token& token, QueryMatch& match) {
+    const auto& steps = query.steps;
+    const size_t current = index++;
+
+    // Nothing in progress: only a token matching the first step matters
+    if (live == 0 && !steps[0].matches(token)) {
+        return false;
+    }
+
+    starts[0] = current;
+    std::fill(next.begin(), next.end(), NONE);
+    for (size_t k = 0; k < steps.size(); ++k) {
+        bool canStart = starts[k] != NONE;
+        bool canRepeat = steps[k].repeat && starts[k + 1] != NONE;
+        if ((canStart || canRepeat) && steps[k].matches(token)) {
+            size_t start = canStart ? starts[k] : NONE;
+            if (canRepeat) {
+                start = std::min(start, starts[k + 1]);
+            }
+            next[k + 1] = std::min(next[k + 1], start);
+        }
+    }
+    close(next);
+    starts.swap(next);
+    starts[0] = NONE;
+
+    const size_t accept = steps.size();
+    if (starts[accept] != NONE) {
+        match = {starts[accept], current};
+        std::fill(starts.begin(), starts.end(), NONE);
+        live = 0;
+        return true;
+    }
+
+    live = static_cast<size_t>(std::count_if(starts.begin(), starts.end(), [](size_t s) { return s != NONE; }));
+    return false;
+}
@@ -0,0 +1,78 @@
+#ifndef TOKEN_QUERY_H
+#define TOKEN_QUERY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Token.h"
+#include "TokenFilter.h"
+
+// A run of tokens matched by a query, as indices of its first and last token
+struct QueryMatch {
+    size_t first;
+    size_t last;
+};
+
+// A pattern over token sequences. Elements are separated by whitespace:
+//
+//   IDENTIFIER            a token of this type (type names or groups as for
+//   strings|comments      --drop, alternatives separated by '|')
+//   'if'  "=="            a token with exactly this text, of any type
+//   IDENTIFIER:if         both; the text may be quoted (PARENTHESIS:'(')
+//   _                     any one token
+//   *                     any number of tokens
+//   *{n}  *{m,n}  *{m,}   between m and n tokens
+//
+// The query is compiled into a list of steps and run as an NFA that tracks,
+// for every step, the earliest start of a partial match that reached it, so
+// a token buffer is matched in one pass. A match is reported at the token
+// that completes it; partial matches overlapping it are dropped.
+class TokenQuery {
+private:
+    struct Step {
+        TokenFilter types;
+        std::string lexeme;
+        bool anyType;
+        bool anyLexeme;
+        bool optional; // may be skipped
+        bool repeat;   // may match any number of tokens
+
+        bool matches(const Token& token) const;
+    };
+
+    std::vector<Step> steps;
+    std::string text;
+
+public:
+    // Parse a query; on failure error describes the problem
+    static bool parse(const std::string& query, TokenQuery& result, std::string& error);
+
+    const std::string& getText() const { return text; }
+    size_t stepCount() const { return steps.size(); }
+
+    // All matches in a token buffer, in order
+    std::vector<QueryMatch> findAll(const std::vector<Token>& tokens) const;
+
+    // Matches tokens as they arrive, e.g. from Lexer::tokenize
+    class Matcher {
+    private:
+        const TokenQuery& query;
+        std::vector<size_t> starts; // per state, earliest start or NONE
+        std::vector<size_t> next;
+        size_t index;
+        size_t live;
+
+        void close(std::vector<size_t>& states) const;
+
+    public:
+        explicit Matcher(const TokenQuery& query);
+
+        void reset();
+
+        // Feed the next token; returns true and sets match when it
+        // completes one
+        bool feed(const Token& token, QueryMatch& match);
+    };
+};
+
+#endif // TOKEN_QUERY_H
@@ -0,0 +1,330 @@
+#include "XrefIndex.h"
+#include "Lexer.h"
+#include "SymbolTableBuilder.h"
+#include "Varint.h"
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+
+namespace {
+
+const char MAGIC[4] = {'L', 'X', 'X', 'R'};
+const size_t HEADER_SIZE = 48;
+const size_t FILE_ENTRY_SIZE = 24;
+const size_t NAME_ENTRY_SIZE = 24;
+
+// Append text to the string section, returning its offset
+uint32_t appendString(std::string& strings, std::string_view text) {
+    uint32_t offset = static_cast<uint32_t>(strings.size());
+    strings.append(text.data(), text.size());
+    return offset;
+}
+
+} // namespace
+
+// XrefFileOccurrences implementation
+XrefFileOccurrences XrefFileOccurrences::collect(const std::string& source, const LanguageConfig& config,
+                                                 const std::string& filename) {
+    XrefFileOccurrences found;
+    std::unordered_map<std::string, uint32_t> ids;
+
+    Lexer lexer(source, config, filename);
+    lexer.setSymbolMode(SymbolMode::OFF);
+    SymbolTableBuilder builder(nullptr, config);
+
+    lexer.tokenize([&](const Token& token) {
+        const Symbol* symbol = builder.add(token);
+        if (!symbol) {
+            return;
+        }
+        auto id = ids.emplace(token.lexeme, static_cast<uint32_t>(found.names.size()));
+        if (id.second) {
+            found.names.push_back(token.lexeme);
+        }
+        XrefOccurrence occurrence;
+        occurrence.file = 0;
+        occurrence.offset = token.location.offset;
+        occurrence.line = static_cast<uint32_t>(std::max(token.location.line, 0));
+        occurrence.column = static_cast<uint32_t>(std::max(token.location.column, 0));
+        occurrence.declaration = symbol->getLine() == token.location.line &&
+                                 symbol->getColumn() == token.location.column;
+        found.occurrences.emplace_back(id.first->second, occurrence);
+    });
+    return found;
+}
+
+// XrefIndexBuilder implementation
+XrefIndexBuilder::XrefIndexBuilder() : occurrenceTotal(0) {}
+
+uint32_t XrefIndexBuilder::intern(std::string_view name) {
+    auto inserted = nameIds.emplace(std::string(name), static_cast<uint32_t>(names.size()));
+    if (inserted.second) {
+        names.push_back(&inserted.first->first);
+        postings.emplace_back();
+    }
+    return inserted.first->second;
+}
+
+uint32_t XrefIndexBuilder::addFile(const XrefFile& file) {
+    files.push_back(file);
+    return static_cast<uint32_t>(files.size() - 1);
+}
+
+uint32_t XrefIndexBuilder::addFile(const XrefFile& file, const XrefFileOccurrences& found) {
+    uint32_t id = addFile(file);
+    std::vector<uint32_t> nameMap;
+    nameMap.reserve(found.names.size());
+    for (const auto& name : found.names) {
+        nameMap.push_back(intern(name));
+    }
+    for (const auto& entry : found.occurrences) {
+        XrefOccurrence occurrence = entry.second;
+        occurrence.file = id;
+        postings[nameMap[entry.first]].push_back(occurrence);
+    }
+    occurrenceTotal += found.occurrences.size();
+    return id;
+}
+
+void XrefIndexBuilder::add(std::string_view name, const XrefOccurrence& occurrence) {
+    postings[intern(name)].push_back(occurrence);
+    ++occurrenceTotal;
+}
+
+bool XrefIndexBuilder::write(const std::string& filename, std::string& error) {
+    std::string stringSection;
+    std::string fileSection;
+    for (const auto& file : files) {
+        appendU64(fileSection, file.size);
+        appendU64(fileSection, static_cast<uint64_t>(file.modified));
+        appendU32(fileSection, appendString(stringSection, file.path));
+        appendU32(fileSection, static_cast<uint32_t>(file.path.size()));
+    }
+
+    std::vector<uint32_t> order(names.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return *names[a] < *names[b]; });
+
+    std::string nameSection;
+    std::string postingSection;
+    for (uint32_t id : order) {
+        auto& list = postings[id];
+        std::sort(list.begin(), list.end(), [](const XrefOccurrence& a, const XrefOccurrence& b) {
+            return a.file != b.file ? a.file < b.file : a.offset < b.offset;
+        });
+
+        appendU64(nameSection, postingSection.size());
+        appendU32(nameSection, static_cast<uint32_t>(list.size()));
+        appendU32(nameSection, appendString(stringSection, *names[id]));
+        appendU32(nameSection, static_cast<uint32_t>(names[id]->size()));
+        appendU32(nameSection, 0);
+
+        uint32_t previousFile = 0;
+        uint64_t previousOffset = 0;
+        uint32_t previousLine = 0;
+        for (const auto& occurrence : list) {
+            if (occurrence.file != previousFile) {
+                previousOffset = 0;
+                previousLine = 0;
+            }
+            appendVarint(postingSection, occurrence.file - previousFile);
+            appendVarint(postingSection, ((occurrence.offset - previousOffset) << 1) | (occurrence.declaration ? 1 : 0));
+            appendVarint(postingSection, occurrence.line - previousLine);
+            appendVarint(postingSection, occurrence.column);
+            previousFile = occurrence.file;
+            previousOffset = occurrence.offset;
+            previousLine = occurrence.line;
+        }
+    }
+
+    const uint64_t namesOffset = HEADER_SIZE + fileSection.size();
+    const uint64_t postingsOffset = namesOffset + nameSection.size();
+    const uint64_t stringsOffset = postingsOffset + postingSection.size();
+
+    std::string header(MAGIC, 4);
+    appendU16(header, XrefFormat::VERSION);
+    appendU16(header, 0);
+    appendU32(header, static_cast<uint32_t>(files.size()));
+    appendU32(header, static_cast<uint32_t>(names.size()));
+    appendU64(header, occurrenceTotal);
+    appendU64(header, namesOffset);
+    appendU64(header, postingsOffset);
+    appendU64(header, stringsOffset);
+
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            error = "could not create " + temporary;
+            return false;
+        }
+        out << header << fileSection << nameSection << postingSection << stringSection;
+        if (!out.flush()) {
+            error = "could not write " + temporary;
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        error = "could not replace " + filename;
+        return false;
+    }
+    return true;
+}
+
+// XrefIndex implementation
+XrefIndex::XrefIndex() {
+    close();
+}
+
+bool XrefIndex::fail(const std::string& message) {
+    error = message;
+    file.close();
+    fileTotal = 0;
+    nameTotal = 0;
+    occurrenceTotal = 0;
+    return false;
+}
+
+void XrefIndex::close() {
+    file.close();
+    error.clear();
+    fileTotal = 0;
+    nameTotal = 0;
+    occurrenceTotal = 0;
+    fileTable = nullptr;
+    nameTable = nullptr;
+    postings = nullptr;
+    postingsEnd = nullptr;
+    strings = nullptr;
+    stringsSize = 0;
+}
+
+bool XrefIndex::open(const std::string& filename) {
+    close();
+    if (!file.open(filename)) {
+        return fail("could not open " + filename);
+    }
+    const uint8_t* data = file.bytes();
+    const uint64_t size = file.size();
+    if (size < HEADER_SIZE || !std::equal(MAGIC, MAGIC + 4, reinterpret_cast<const char*>(data))) {
+        return fail(filename + " is not a cross-reference index");
+    }
+    if (loadU16(data + 4) != XrefFormat::VERSION) {
+        return fail(filename + " has unsupported version " + std::to_string(loadU16(data + 4)));
+    }
+
+    const uint32_t files = loadU32(data + 8);
+    const uint32_t names = loadU32(data + 12);
+    const uint64_t namesOffset = loadU64(data + 24);
+    const uint64_t postingsOffset = loadU64(data + 32);
+    const uint64_t stringsOffset = loadU64(data + 40);
+    if (namesOffset != HEADER_SIZE + static_cast<uint64_t>(files) * FILE_ENTRY_SIZE ||
+        postingsOffset != namesOffset + static_cast<uint64_t>(names) * NAME_ENTRY_SIZE ||
+        stringsOffset < postingsOffset || stringsOffset > size) {
+        return fail(filename + " is truncated or corrupt");
+    }
+
+    fileTotal = files;
+    nameTotal = names;
+    occurrenceTotal = loadU64(data + 16);
+    fileTable = data + HEADER_SIZE;
+    nameTable = data + namesOffset;
+    postings = data + postingsOffset;
+    postingsEnd = data + stringsOffset;
+    strings = data + stringsOffset;
+    stringsSize = size - stringsOffset;
+    return true;
+}
+
+std::string_view XrefIndex::string(uint32_t offset, uint32_t length) const {
+    if (static_cast<uint64_t>(offset) + length > stringsSize) {
+        return std::string_view();
+    }
+    return std::string_view(reinterpret_cast<const char*>(strings + offset), length);
+}
+
+XrefFile XrefIndex::getFile(size_t index) const {
+    const uint8_t* entry = fileTable + index * FILE_ENTRY_SIZE;
+    XrefFile result;
+    result.size = loadU64(entry);
+    result.modified = static_cast<int64_t>(loadU64(entry + 8));
+    result.path = std::string(string(loadU32(entry + 16), loadU32(entry + 20)));
+    return result;
+}
+
+std::string_view XrefIndex::name(size_t index) const {
+    const uint8_t* entry = nameTable + index * NAME_ENTRY_SIZE;
+    return string(loadU32(entry + 12), loadU32(entry + 16));
+}
+
+size_t XrefIndex::findName(std::string_view target) const {
+    size_t low = 0;
+    size_t high = nameTotal;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (name(middle) < target) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < nameTotal && name(low) == target ? low : NONE;
+}
+
+std::vector<XrefOccurrence> XrefIndex::occurrences(size_t nameIndex, bool* corrupt) const {
+    std::vector<XrefOccurrence> result;
+    if (corrupt) {
+        *corrupt = false;
+    }
+    if (nameIndex >= nameTotal) {
+        return result;
+    }
+    auto fail = [&]() {
+        if (corrupt) {
+            *corrupt = true;
+        }
+        return std::vector<XrefOccurrence>();
+    };
+    const uint8_t* entry = nameTable + nameIndex * NAME_ENTRY_SIZE;
+    const uint64_t start = loadU64(entry);
+    const uint32_t count = loadU32(entry + 8);
+    const uint64_t available = static_cast<uint64_t>(postingsEnd - postings);
+    // Every occurrence takes at least one byte per field, so the count can
+    // be checked before anything is allocated for it
+    if (start > available || count > (available - start) / 4) {
+        return fail();
+    }
+
+    const uint8_t* cursor = postings + start;
+    uint64_t fileId = 0;
+    uint64_t offset = 0;
+    uint64_t line = 0;
+    result.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t fileDelta, offsetField, lineDelta, column;
+        if (!readVarint(cursor, postingsEnd, fileDelta) || !readVarint(cursor, postingsEnd, offsetField) ||
+            !readVarint(cursor, postingsEnd, lineDelta) || !readVarint(cursor, postingsEnd, column)) {
+            return fail();
+        }
+        if (fileDelta != 0) {
+            offset = 0;
+            line = 0;
+        }
+        fileId += fileDelta;
+        offset += offsetField >> 1;
+        line += lineDelta;
+        if (fileId >= fileTotal) {
+            return fail();
+        }
+        result.push_back({static_cast<uint32_t>(fileId), offset, static_cast<uint32_t>(line),
+                          static_cast<uint32_t>(column), (offsetField & 1) != 0});
+    }
+    return result;
+}
+
+std::vector<XrefOccurrence> XrefIndex::find(std::string_view target, bool* corrupt) const {
+    return occurrences(findName(target), corrupt);
+}
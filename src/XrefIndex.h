@@ -0,0 +1,140 @@
+#ifndef XREF_INDEX_H
+#define XREF_INDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "LanguageConfig.h"
+#include "MappedFile.h"
+
+// Persistent cross-reference index of identifiers ("LXXR"). All integers
+// are little-endian.
+//
+//   header    magic "LXXR", u16 version, u16 reserved, u32 file count,
+//             u32 name count, u64 occurrence count, u64 names offset,
+//             u64 postings offset, u64 strings offset
+//   files     per file: u64 size, i64 modification time, u32 path offset,
+//             u32 path length (into strings)
+//   names     per name, sorted by bytes: u64 postings offset (relative),
+//             u32 occurrence count, u32 name offset, u32 name length,
+//             u32 reserved
+//   postings  per name, occurrences sorted by file and offset: varint file
+//             delta, varint (offset delta << 1 | declaration), varint line
+//             delta, varint column; offset and line restart in every file
+//   strings   file paths and names
+//
+// Lookups binary-search the mapped name table and decode one posting list,
+// so a query touches a few pages however large the index is.
+namespace XrefFormat {
+    constexpr uint16_t VERSION = 1;
+}
+
+// One identifier in one file. A declaration is the occurrence a name was
+// first recorded at in its scope (see SymbolTableBuilder); the rest are uses.
+struct XrefOccurrence {
+    uint32_t file;
+    uint64_t offset;
+    uint32_t line;
+    uint32_t column;
+    bool declaration;
+};
+
+// An indexed file and the size and modification time it was lexed at
+struct XrefFile {
+    std::string path;
+    uint64_t size;
+    int64_t modified;
+};
+
+// Identifier occurrences of one file, collected on a worker thread before
+// names get index-wide ids. Occurrences refer to names by position.
+struct XrefFileOccurrences {
+    std::vector<std::string> names;
+    std::vector<std::pair<uint32_t, XrefOccurrence>> occurrences;
+
+    // Lex the source and record every identifier that is not a reserved word
+    static XrefFileOccurrences collect(const std::string& source, const LanguageConfig& config,
+                                       const std::string& filename);
+};
+
+// Collects occurrences in memory and writes the index file
+class XrefIndexBuilder {
+private:
+    std::vector<XrefFile> files;
+    std::unordered_map<std::string, uint32_t> nameIds;
+    std::vector<const std::string*> names;
+    std::vector<std::vector<XrefOccurrence>> postings;
+    uint64_t occurrenceTotal;
+
+    uint32_t intern(std::string_view name);
+
+public:
+    XrefIndexBuilder();
+
+    // Register a file; its id is the order of registration
+    uint32_t addFile(const XrefFile& file);
+
+    // Register a file with the occurrences collected in it
+    uint32_t addFile(const XrefFile& file, const XrefFileOccurrences& found);
+
+    // Add an occurrence to a registered file (occurrence.file)
+    void add(std::string_view name, const XrefOccurrence& occurrence);
+
+    size_t fileCount() const { return files.size(); }
+    size_t nameCount() const { return names.size(); }
+    uint64_t occurrenceCount() const { return occurrenceTotal; }
+
+    // Write to a temporary file and rename it over filename, so readers
+    // never see a partial index
+    bool write(const std::string& filename, std::string& error);
+};
+
+// Read-only view of an index file; the file is memory-mapped
+class XrefIndex {
+private:
+    MappedFile file;
+    std::string error;
+
+    uint32_t fileTotal;
+    uint32_t nameTotal;
+    uint64_t occurrenceTotal;
+    const uint8_t* fileTable;
+    const uint8_t* nameTable;
+    const uint8_t* postings;
+    const uint8_t* postingsEnd;
+    const uint8_t* strings;
+    uint64_t stringsSize;
+
+    bool fail(const std::string& message);
+    std::string_view string(uint32_t offset, uint32_t length) const;
+
+public:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    XrefIndex();
+
+    // Map and validate an index file
+    bool open(const std::string& filename);
+    void close();
+    const std::string& getError() const { return error; }
+
+    size_t fileCount() const { return fileTotal; }
+    XrefFile getFile(size_t index) const;
+
+    size_t nameCount() const { return nameTotal; }
+    uint64_t occurrenceCount() const { return occurrenceTotal; }
+    std::string_view name(size_t index) const;
+
+    // Index of a name in the sorted name table, or NONE
+    size_t findName(std::string_view name) const;
+
+    // Decode the occurrences of a name, in file and offset order. A list
+    // that is truncated or points outside the file table decodes to
+    // nothing and sets *corrupt.
+    std::vector<XrefOccurrence> occurrences(size_t nameIndex, bool* corrupt = nullptr) const;
+    std::vector<XrefOccurrence> find(std::string_view name, bool* corrupt = nullptr) const;
+};
+
+#endif // XREF_INDEX_H
@@ -5,12 +5,34 @@
 #include <vector>
 #include <memory>
 #include <chrono>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
+#include <cctype>
+#include <unistd.h>
 #include "Lexer.h"
 #include "LanguageConfig.h"
 #include "SymbolTable.h"
 #include "ExportFormatter.h"
+#include "HtmlPagesExporter.h"
+#include "TeeWriter.h"
+#include "DatasetWriter.h"
+#include "Extractor.h"
+#include "MappedFile.h"
+#include "PatternMatcher.h"
+#include "CodeSearch.h"
+#include "TokenQuery.h"
+#include "ScopeIndex.h"
+#include "SymbolSearchIndex.h"
+#include "ProjectSymbolTable.h"
+#include "XrefIndex.h"
+#include "TagFile.h"
+#include "BloomIndex.h"
+#include <filesystem>
 #include "ConfigLoader.h"
 #include "LanguagePlugin.h"
+#include "ThreadPool.h"
 
 // Utility functions
 std::string readFile(const std::string& filename) {
@@ -107,9 +129,192 @@ void processString(const std::string& source, const LanguageConfig& config, bool
     }
 }
 
+// Guess the language from a file extension, keeping the given default
+std::string detectLanguage(const std::string& filename, const std::string& fallback) {
+    size_t dotPos = filename.find_last_of('.');
+    if (dotPos != std::string::npos) {
+        std::string ext = filename.substr(dotPos + 1);
+        if (ext == "c") return "c";
+        else if (ext == "cpp" || ext == "cc" || ext == "cxx" || ext == "hpp" || ext == "h") return "c++";
+        else if (ext == "java") return "java";
+        else if (ext == "py") return "python";
+        else if (ext == "js") return "javascript";
+    }
+    return fallback;
+}
+
+// One export destination (-e format:path, or -e format with -o path)
+struct ExportTarget {
+    std::string format;
+    std::string file;
+};
+
+// Export settings collected from the command line
+struct ExportOptions {
+    std::vector<ExportTarget> targets;
+    ExportFields fields = ExportField::ALL;
+    size_t pageLines = HtmlPagesExporter::DEFAULT_PAGE_LINES;
+    size_t jobs = 1;
+
+    bool enabled() const { return !targets.empty(); }
+};
+
+// Status messages move to stderr when an export goes to stdout
+std::ostream& statusStream(const ExportOptions& options) {
+    for (const auto& target : options.targets) {
+        if (target.file == "-") {
+            return std::cerr;
+        }
+    }
+    return std::cout;
+}
+
+// Create the exporter for a target; reports and returns nullptr if the
+// format is unknown
+std::unique_ptr<TokenExporter> createExporter(const ExportTarget& target, const ExportOptions& options) {
+    ExporterFactory::Format format;
+    if (!ExporterFactory::parseFormat(target.format, format)) {
+        std::cerr << "Unsupported export format: " << target.format << std::endl;
+        return nullptr;
+    }
+    
+    auto exporter = ExporterFactory::createExporter(format, options.fields);
+    if (auto pages = dynamic_cast<HtmlPagesExporter*>(exporter.get())) {
+        pages->setPageLines(options.pageLines);
+    }
+    return exporter;
+}
+
+// Open a writer for every target. Several targets share one token stream
+// through a TeeWriter, each on its own thread when more than one job is
+// allowed. Reports and returns nullptr if a target can't be opened.
+std::unique_ptr<TokenWriter> openExportWriter(const ExportOptions& options) {
+    std::vector<std::unique_ptr<TokenWriter>> writers;
+    for (const auto& target : options.targets) {
+        auto exporter = createExporter(target, options);
+        if (!exporter) {
+            return nullptr;
+        }
+        
+        auto writer = exporter->openFile(target.file);
+        if (!writer) {
+            std::cerr << "Failed to export tokens to " << target.file << std::endl;
+            return nullptr;
+        }
+        if (options.targets.size() > 1 && options.jobs > 1) {
+            writer = AsyncTokenWriter::create(std::move(writer));
+        }
+        writers.push_back(std::move(writer));
+    }
+    
+    if (writers.size() == 1) {
+        return std::move(writers.front());
+    }
+    return TeeWriter::create(std::move(writers));
+}
+
+void reportExport(std::ostream& out, const ExportTarget& target, bool success) {
+    if (success) {
+        out << "Tokens exported to " << target.file << " in " << target.format << " format." << std::endl;
+    } else {
+        std::cerr << "Failed to export tokens to " << target.file << std::endl;
+    }
+}
+
+// Finish an export writer and report the outcome of every target
+void finishExport(std::ostream& out, const ExportOptions& options, TokenWriter& writer) {
+    bool success = writer.finish();
+    auto tee = dynamic_cast<TeeWriter*>(&writer);
+    for (size_t i = 0; i < options.targets.size(); ++i) {
+        reportExport(out, options.targets[i], tee ? tee->succeeded(i) : success);
+    }
+}
+
+// Literal patterns searched for in selected token types while lexing
+struct PatternScan {
+    MultiPatternMatcher matcher;
+    TokenFilter types;
+    std::vector<PatternHit> hits;
+    
+    void scan(const Token& token) {
+        if (types.accepts(token)) {
+            matcher.scan(token, [this](const PatternHit& hit) { hits.push_back(hit); });
+        }
+    }
+};
+
+void reportPatternHits(std::ostream& out, const PatternScan& patterns) {
+    out << "\nPattern matches:" << std::endl;
+    for (const auto& hit : patterns.hits) {
+        out << hit.location.toString() << ": " << patterns.matcher.pattern(hit.pattern) << std::endl;
+    }
+    out << patterns.hits.size() << " matches for " << patterns.matcher.size() << " patterns" << std::endl;
+}
+
+void reportBrackets(std::ostream& out, const BracketIndex& brackets) {
+    out << "\nDelimiters: " << brackets.pairs() << " pairs, maximum depth " << brackets.maximumDepth() << std::endl;
+    if (!brackets.isBalanced()) {
+        out << "Unbalanced delimiters:" << std::endl;
+        out << brackets.report();
+    }
+}
+
+// Print the scopes enclosing a position and the symbols visible there
+void reportScopeAt(std::ostream& out, const SymbolTable& symbolTable, int line, int column) {
+    ScopeIndex index(symbolTable.getGlobalScope());
+    out << "\nScopes at " << line << ":" << column << " (" << index.scopeCount() << " scopes):" << std::endl;
+    for (const Scope* scope = index.scopeAt(line, column); scope; scope = scope->getParent()) {
+        out << "  " << scope->toString() << std::endl;
+    }
+    
+    std::vector<const Symbol*> visible = index.visibleSymbols(line, column);
+    out << "Visible symbols (" << visible.size() << "):" << std::endl;
+    for (const Symbol* symbol : visible) {
+        out << "  " << symbol->getName() << " at " << symbol->getLine() << ":" << symbol->getColumn() << std::endl;
+    }
+}
+
+// Completion and fuzzy "go to symbol" lookups over a file's symbols
+void reportSymbolSearch(std::ostream& out, const SymbolTable& symbolTable, const std::string& prefix,
+                        const std::string& fuzzy) {
+    const size_t limit = 20;
+    SymbolSearchIndex index(symbolTable);
+    
+    auto print = [&](const std::string& title, const std::vector<SymbolMatch>& matches, long long micros) {
+        out << "\n" << title << " (" << matches.size() << " of " << index.size() << " names, " << micros
+            << " us):" << std::endl;
+        for (const auto& match : matches) {
+            const Symbol* first = symbolTable.findSymbols(match.nameId).front();
+            out << "  " << *match.name << " at " << first->getLine() << ":" << first->getColumn();
+            if (match.score < 1.0) {
+                out << " (" << static_cast<int>(match.score * 100 + 0.5) << "%)";
+            }
+            out << std::endl;
+        }
+    };
+    
+    if (!prefix.empty()) {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto matches = index.prefix(prefix, limit);
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - start).count();
+        print("Names starting with '" + prefix + "'", matches, micros);
+    }
+    if (!fuzzy.empty()) {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto matches = index.fuzzy(fuzzy, limit);
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - start).count();
+        print("Names like '" + fuzzy + "'", matches, micros);
+    }
+}
+
 void processFile(const std::string& filename, const std::string& language, bool verbose = false, 
-                const std::string& exportFormat = "", const std::string& exportFile = "",
-                const std::string& configFile = "") {
+                const ExportOptions& exportOptions = ExportOptions(), const std::string& configFile = "",
+                const TokenFilter& filter = TokenFilter(), PatternScan* patterns = nullptr,
+                bool checkBrackets = false, std::pair<int, int> scopeAt = {0, 0},
+                SymbolMode symbolMode = SymbolMode::INLINE, const std::string& completePrefix = "",
+                const std::string& fuzzyQuery = "") {
     std::string source = readFile(filename);
     if (source.empty()) {
         return;
@@ -117,73 +322,1180 @@ void processFile(const std::string& filename, const std::string& language, bool
     
     // Get language configuration
     LanguageConfig config = getLanguageConfig(language, configFile);
+    std::ostream& out = statusStream(exportOptions);
     
-    std::cout << "Processing file: " << filename << " (Language: " << config.getName() << ")" << std::endl;
+    out << "Processing file: " << filename << " (Language: " << config.getName() << ")" << std::endl;
     
     // Create lexer with configuration
     Lexer lexer(source, config, filename);
+    lexer.setTokenFilter(filter);
+    lexer.setBracketTracking(checkBrackets);
     
     // Create symbol table
     auto symbolTable = std::make_shared<SymbolTable>();
     lexer.setSymbolTable(symbolTable);
+    lexer.setSymbolMode(symbolMode);
+    const bool deferSymbols = symbolMode == SymbolMode::DEFERRED;
     
-    // Get tokens
+    // A single export that can be formatted in parallel needs the whole
+    // token vector
+    std::unique_ptr<TokenExporter> parallelExporter;
+    if (exportOptions.targets.size() == 1 && exportOptions.jobs > 1) {
+        auto exporter = createExporter(exportOptions.targets.front(), exportOptions);
+        if (!exporter) {
+            return;
+        }
+        if (exporter->supportsChunkedExport()) {
+            parallelExporter = std::move(exporter);
+        }
+    }
+    
+    // Otherwise open every target up front so tokens can be streamed
+    std::unique_ptr<TokenWriter> writer;
+    if (exportOptions.enabled() && !parallelExporter) {
+        writer = openExportWriter(exportOptions);
+        if (!writer) {
+            return;
+        }
+        writer->begin();
+    }
+    
+    // Without verbose output or a deferred symbol pass there is no need to
+    // keep the tokens around: stream them straight into the writer
+    std::vector<Token> tokens;
+    size_t tokenCount = 0;
     auto startTime = std::chrono::high_resolution_clock::now();
-    std::vector<Token> tokens = lexer.tokenize();
+    if (writer && !verbose && !deferSymbols) {
+        tokenCount = lexer.tokenize([&writer, patterns](const Token& token) {
+            if (patterns) {
+                patterns->scan(token);
+            }
+            writer->write(token);
+        });
+    } else {
+        tokens = lexer.tokenize();
+        tokenCount = tokens.size();
+        if (patterns) {
+            for (const auto& token : tokens) {
+                patterns->scan(token);
+            }
+        }
+    }
     auto endTime = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
     
+    // Deferred symbols are built on another thread while results are
+    // reported and exported; whatever reads the table waits for it
+    SymbolTableBuilder symbolBuilder(symbolTable, config);
+    std::future<void> symbolsBuilt;
+    if (deferSymbols) {
+        symbolsBuilt = symbolBuilder.buildAsync(tokens);
+    }
+    auto waitForSymbols = [&symbolsBuilt]() {
+        if (symbolsBuilt.valid()) {
+            symbolsBuilt.get();
+        }
+    };
+    
     // Display results
-    std::cout << "Lexical Analysis Results:" << std::endl;
-    std::cout << "------------------------" << std::endl;
-    std::cout << "Total tokens: " << tokens.size() << std::endl;
-    std::cout << "Processing time: " << duration << " ms" << std::endl;
+    out << "Lexical Analysis Results:" << std::endl;
+    out << "------------------------" << std::endl;
+    out << "Total tokens: " << tokenCount << std::endl;
+    out << "Processing time: " << duration << " ms" << std::endl;
     
     if (lexer.hasErrors()) {
-        std::cout << "\nErrors found during lexical analysis:" << std::endl;
-        std::cout << lexer.getErrorReport();
+        out << "\nErrors found during lexical analysis:" << std::endl;
+        out << lexer.getErrorReport();
     } else {
-        std::cout << "No lexical errors detected." << std::endl;
+        out << "No lexical errors detected." << std::endl;
+    }
+    
+    if (checkBrackets) {
+        reportBrackets(out, lexer.getBracketIndex());
+    }
+    
+    if (scopeAt.first > 0) {
+        waitForSymbols();
+        reportScopeAt(out, *symbolTable, scopeAt.first, scopeAt.second);
+    }
+    
+    if (!completePrefix.empty() || !fuzzyQuery.empty()) {
+        waitForSymbols();
+        reportSymbolSearch(out, *symbolTable, completePrefix, fuzzyQuery);
+    }
+    
+    if (patterns) {
+        reportPatternHits(out, *patterns);
     }
     
     if (verbose) {
-        std::cout << "\nTokens:" << std::endl;
+        out << "\nTokens:" << std::endl;
         for (const auto& token : tokens) {
-            std::cout << token.toString() << std::endl;
+            out << token.toString() << std::endl;
         }
         
         // Show symbol table
-        std::cout << "\nSymbol Table:" << std::endl;
-        std::cout << symbolTable->toString() << std::endl;
+        waitForSymbols();
+        out << "\nSymbol Table:" << std::endl;
+        out << symbolTable->toString() << std::endl;
     }
     
     // Export tokens if requested
-    if (!exportFormat.empty() && !exportFile.empty()) {
-        ExporterFactory::Format format;
+    if (parallelExporter) {
+        const ExportTarget& target = exportOptions.targets.front();
+        ThreadPool pool(exportOptions.jobs);
+        reportExport(out, target, parallelExporter->exportToFileParallel(tokens, target.file, pool));
+    } else if (writer) {
+        if (verbose || deferSymbols) {
+            for (const auto& token : tokens) {
+                writer->write(token);
+            }
+        }
+        finishExport(out, exportOptions, *writer);
+    }
+    waitForSymbols();
+}
+
+// Size and modification time identify a file version for incremental runs
+bool statSourceFile(const std::string& path, XrefFile& file) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    file.path = path;
+    file.size = fs::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    file.modified = static_cast<int64_t>(fs::last_write_time(path, error).time_since_epoch().count());
+    return !error;
+}
+
+// Lex several files in one run. When exporting, all files stream into a
+// single writer, so e.g. NDJSON output for a whole tree is one stream.
+void processBatch(const std::vector<std::string>& filenames, const std::string& language,
+                  bool detectLanguages, const ExportOptions& exportOptions = ExportOptions(),
+                  const std::string& configFile = "", const TokenFilter& filter = TokenFilter(),
+                  PatternScan* patterns = nullptr, bool checkBrackets = false,
+                  SymbolMode symbolMode = SymbolMode::OFF, const std::string& bloomFile = "") {
+    std::ostream& out = statusStream(exportOptions);
+    
+    // Identifier filters are added to the sidecar's entries for other files
+    std::unique_ptr<BloomIndexBuilder> bloom;
+    std::vector<uint64_t> identifierHashes;
+    if (!bloomFile.empty()) {
+        bloom = std::make_unique<BloomIndexBuilder>();
+        BloomIndex previous;
+        if (previous.open(bloomFile)) {
+            for (size_t i = 0; i < previous.fileCount(); ++i) {
+                bloom->add(previous.getFile(i), previous.getFilterWords(i));
+            }
+        }
+    }
+    
+    std::unique_ptr<TokenWriter> writer;
+    if (exportOptions.enabled()) {
+        writer = openExportWriter(exportOptions);
+        if (!writer) {
+            return;
+        }
+        writer->begin();
+    }
+    
+    // Plugin configurations are parsed once per language
+    std::map<std::string, LanguageConfig> configs;
+    size_t totalTokens = 0;
+    size_t filesWithErrors = 0;
+    auto startTime = std::chrono::high_resolution_clock::now();
+    
+    for (const auto& filename : filenames) {
+        std::string source = readFile(filename);
+        if (source.empty()) {
+            continue;
+        }
+        
+        std::string fileLanguage = detectLanguages ? detectLanguage(filename, language) : language;
+        auto configIt = configs.find(fileLanguage);
+        if (configIt == configs.end()) {
+            configIt = configs.emplace(fileLanguage, getLanguageConfig(fileLanguage, configFile)).first;
+        }
+        
+        // Identifier filters must cover every identifier, so with --bloom
+        // the lexer keeps them and the user's filter is applied here
+        TokenFilter lexerFilter = filter;
+        if (bloom) {
+            lexerFilter.keep(TokenType::IDENTIFIER);
+            lexerFilter.keep(TokenType::KEYWORD);
+        }
         
-        if (exportFormat == "json") {
-            format = ExporterFactory::Format::JSON;
-        } else if (exportFormat == "xml") {
-            format = ExporterFactory::Format::XML;
-        } else if (exportFormat == "csv") {
-            format = ExporterFactory::Format::CSV;
-        } else if (exportFormat == "html") {
-            format = ExporterFactory::Format::HTML;
+        Lexer lexer(source, configIt->second, filename);
+        lexer.setTokenFilter(lexerFilter);
+        lexer.setBracketTracking(checkBrackets);
+        lexer.setSymbolMode(symbolMode);
+        identifierHashes.clear();
+        size_t count = 0;
+        lexer.tokenize([&](const Token& token) {
+            if (bloom && (token.type == TokenType::IDENTIFIER || token.type == TokenType::KEYWORD)) {
+                identifierHashes.push_back(hashBytes(token.lexeme));
+            }
+            if (bloom && !filter.accepts(token)) {
+                return;
+            }
+            ++count;
+            if (patterns) {
+                patterns->scan(token);
+            }
+            if (writer) {
+                writer->write(token);
+            }
+        });
+        totalTokens += count;
+        
+        XrefFile stat;
+        if (bloom && statSourceFile(filename, stat)) {
+            BloomFilter identifierFilter = BloomFilter::build(std::move(identifierHashes));
+            bloom->add({filename, stat.size, stat.modified, hashBytes(source)}, identifierFilter.getWords());
+        }
+        
+        out << filename << ": " << count << " tokens";
+        if (lexer.hasErrors()) {
+            out << ", " << lexer.getErrors().size() << " errors";
+            filesWithErrors++;
+        }
+        const BracketIndex& brackets = lexer.getBracketIndex();
+        if (checkBrackets && !brackets.isBalanced()) {
+            out << ", " << brackets.getDiagnostics().size() << " unbalanced delimiters" << std::endl;
+            out << brackets.report();
         } else {
-            std::cerr << "Unsupported export format: " << exportFormat << std::endl;
+            out << std::endl;
+        }
+    }
+    
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    
+    out << "Processed " << filenames.size() << " files, " << totalTokens << " tokens in "
+        << duration << " ms";
+    if (filesWithErrors > 0) {
+        out << " (" << filesWithErrors << " files with errors)";
+    }
+    out << std::endl;
+    
+    if (patterns) {
+        reportPatternHits(out, *patterns);
+    }
+    
+    if (bloom) {
+        std::string error;
+        if (bloom->write(bloomFile, error)) {
+            out << "Identifier filters for " << bloom->fileCount() << " files written to " << bloomFile << std::endl;
+        } else {
+            std::cerr << "Error: " << error << std::endl;
+        }
+    }
+    
+    if (writer) {
+        finishExport(out, exportOptions, *writer);
+    }
+}
+
+// Lex a file list into ML dataset columns. Files are lexed on the pool in
+// waves and merged in input order, so the vocabulary and the arrays do not
+// depend on the number of jobs.
+void processDataset(const std::vector<std::string>& filenames, const std::string& language,
+                    bool detectLanguages, const std::string& directory,
+                    DatasetWriter::Format format, size_t jobs, const std::string& configFile = "",
+                    const TokenFilter& filter = TokenFilter()) {
+    DatasetWriter dataset(directory, format);
+    if (!dataset.open()) {
+        std::cerr << "Failed to create dataset in " << directory << std::endl;
+        return;
+    }
+    
+    // Resolve configurations up front; the plugin manager is not shared
+    // with the worker threads
+    std::map<std::string, LanguageConfig> configs;
+    std::vector<const LanguageConfig*> fileConfigs;
+    for (const auto& filename : filenames) {
+        std::string fileLanguage = detectLanguages ? detectLanguage(filename, language) : language;
+        auto configIt = configs.find(fileLanguage);
+        if (configIt == configs.end()) {
+            configIt = configs.emplace(fileLanguage, getLanguageConfig(fileLanguage, configFile)).first;
+        }
+        fileConfigs.push_back(&configIt->second);
+    }
+    
+    ThreadPool pool(jobs);
+    const size_t wave = pool.size() * 2;
+    size_t filesWithErrors = 0;
+    auto startTime = std::chrono::high_resolution_clock::now();
+    
+    for (size_t first = 0; first < filenames.size(); first += wave) {
+        std::vector<DatasetDocument> documents(std::min(wave, filenames.size() - first));
+        pool.parallelFor(documents.size(), [&](size_t i) {
+            DatasetDocument& document = documents[i];
+            document.filename = filenames[first + i];
+            std::string source = readFile(document.filename);
+            if (source.empty()) {
+                return;
+            }
+            Lexer lexer(source, *fileConfigs[first + i], document.filename);
+            lexer.setTokenFilter(filter);
+            lexer.setSymbolMode(SymbolMode::OFF);
+            lexer.tokenize([&document](const Token& token) { document.add(token); });
+            document.errors = lexer.getErrors().size();
+        });
+        
+        for (auto& document : documents) {
+            if (document.errors > 0) {
+                filesWithErrors++;
+            }
+            dataset.addDocument(document);
+        }
+    }
+    
+    bool success = dataset.finish();
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    
+    std::cout << "Processed " << dataset.documentCount() << " files, " << dataset.size() << " tokens, "
+              << dataset.vocabularySize() << " distinct lexemes in " << duration << " ms";
+    if (filesWithErrors > 0) {
+        std::cout << " (" << filesWithErrors << " files with errors)";
+    }
+    std::cout << std::endl;
+    
+    if (success) {
+        std::cout << "Dataset written to " << directory << std::endl;
+    } else {
+        std::cerr << "Failed to write dataset to " << directory << std::endl;
+    }
+}
+
+// Extract comments and/or string literals from a file list without full
+// tokenization. Files are mapped and scanned on the pool in waves; spans
+// are exported (or printed) in input order.
+void processExtract(const std::vector<std::string>& filenames, const std::string& language,
+                    bool detectLanguages, Extractor::Kinds kinds,
+                    const ExportOptions& exportOptions = ExportOptions(), const std::string& configFile = "") {
+    std::ostream& out = statusStream(exportOptions);
+    
+    std::unique_ptr<TokenWriter> writer;
+    if (exportOptions.enabled()) {
+        writer = openExportWriter(exportOptions);
+        if (!writer) {
             return;
         }
+        writer->begin();
+    }
+    
+    // One extractor per language, built before the workers start
+    std::map<std::string, std::unique_ptr<Extractor>> extractors;
+    std::vector<const Extractor*> fileExtractors;
+    for (const auto& filename : filenames) {
+        std::string fileLanguage = detectLanguages ? detectLanguage(filename, language) : language;
+        auto extractorIt = extractors.find(fileLanguage);
+        if (extractorIt == extractors.end()) {
+            auto extractor = std::make_unique<Extractor>(getLanguageConfig(fileLanguage, configFile), kinds);
+            extractorIt = extractors.emplace(fileLanguage, std::move(extractor)).first;
+        }
+        fileExtractors.push_back(extractorIt->second.get());
+    }
+    
+    ThreadPool pool(exportOptions.jobs);
+    const size_t wave = pool.size() * 2;
+    size_t totalSpans = 0;
+    size_t totalBytes = 0;
+    auto startTime = std::chrono::high_resolution_clock::now();
+    
+    for (size_t first = 0; first < filenames.size(); first += wave) {
+        std::vector<std::vector<Token>> spans(std::min(wave, filenames.size() - first));
+        std::vector<size_t> sizes(spans.size(), 0);
+        pool.parallelFor(spans.size(), [&](size_t i) {
+            const std::string& filename = filenames[first + i];
+            MappedFile file;
+            if (!file.open(filename)) {
+                return;
+            }
+            std::string_view source(reinterpret_cast<const char*>(file.bytes()), file.size());
+            sizes[i] = file.size();
+            fileExtractors[first + i]->extract(source, filename,
+                                               [&spans, i](const Token& token) { spans[i].push_back(token); });
+        });
         
-        auto exporter = ExporterFactory::createExporter(format);
-        if (exporter) {
-            bool success = exporter->exportToFile(tokens, exportFile);
-            if (success) {
-                std::cout << "Tokens exported to " << exportFile << " in " << exportFormat << " format." << std::endl;
-            } else {
-                std::cerr << "Failed to export tokens to " << exportFile << std::endl;
+        for (size_t i = 0; i < spans.size(); ++i) {
+            for (const auto& token : spans[i]) {
+                if (writer) {
+                    writer->write(token);
+                } else {
+                    std::cout << token.toString() << std::endl;
+                }
+            }
+            totalSpans += spans[i].size();
+            totalBytes += sizes[i];
+        }
+    }
+    
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    
+    if (writer) {
+        out << "Extracted " << totalSpans << " spans from " << filenames.size() << " files ("
+            << totalBytes << " bytes) in " << duration << " ms" << std::endl;
+        finishExport(out, exportOptions, *writer);
+    }
+}
+
+// Text of a query match for one output line: the lexemes joined by
+// spaces, newlines flattened, cut after 100 characters
+std::string describeMatch(const std::vector<Token>& tokens, const QueryMatch& match) {
+    std::string text;
+    for (size_t i = match.first; i <= match.last && text.size() <= 100; ++i) {
+        if (i > match.first) {
+            text += ' ';
+        }
+        text += tokens[i].lexeme;
+    }
+    std::replace(text.begin(), text.end(), '\n', ' ');
+    if (text.size() > 100) {
+        text = text.substr(0, 97) + "...";
+    }
+    return text;
+}
+
+// Run a token query over files in parallel waves. Each file is matched
+// while it is lexed; matches are printed in input order.
+void processQuery(const std::vector<std::string>& filenames, const std::string& language,
+                  bool detectLanguages, const TokenQuery& query, size_t jobs,
+                  const std::string& configFile = "", const TokenFilter& filter = TokenFilter()) {
+    std::map<std::string, LanguageConfig> configs;
+    std::vector<const LanguageConfig*> fileConfigs;
+    for (const auto& filename : filenames) {
+        std::string fileLanguage = detectLanguages ? detectLanguage(filename, language) : language;
+        auto configIt = configs.find(fileLanguage);
+        if (configIt == configs.end()) {
+            configIt = configs.emplace(fileLanguage, getLanguageConfig(fileLanguage, configFile)).first;
+        }
+        fileConfigs.push_back(&configIt->second);
+    }
+    
+    struct FileMatches {
+        std::vector<Token> tokens;
+        std::vector<QueryMatch> matches;
+    };
+    
+    ThreadPool pool(jobs);
+    const size_t wave = pool.size() * 2;
+    size_t totalMatches = 0;
+    size_t totalTokens = 0;
+    auto startTime = std::chrono::high_resolution_clock::now();
+    
+    for (size_t first = 0; first < filenames.size(); first += wave) {
+        std::vector<FileMatches> results(std::min(wave, filenames.size() - first));
+        pool.parallelFor(results.size(), [&](size_t i) {
+            const std::string& filename = filenames[first + i];
+            std::string source = readFile(filename);
+            if (source.empty()) {
+                return;
+            }
+            FileMatches& result = results[i];
+            Lexer lexer(source, *fileConfigs[first + i], filename);
+            lexer.setTokenFilter(filter);
+            lexer.setSymbolTable(nullptr);
+            
+            TokenQuery::Matcher matcher(query);
+            QueryMatch match;
+            lexer.tokenize([&](const Token& token) {
+                result.tokens.push_back(token);
+                if (matcher.feed(token, match)) {
+                    result.matches.push_back(match);
+                }
+            });
+        });
+        
+        for (const auto& result : results) {
+            for (const auto& match : result.matches) {
+                std::cout << result.tokens[match.first].location.toString() << ": "
+                          << describeMatch(result.tokens, match) << "\n";
+            }
+            totalMatches += result.matches.size();
+            totalTokens += result.tokens.size();
+        }
+    }
+    
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    std::cout << totalMatches << " matches in " << filenames.size() << " files (" << totalTokens
+              << " tokens) in " << duration << " ms" << std::endl;
+}
+
+// Lex files in parallel, each into its own symbol table, publishing them
+// into a project-wide index, and print where each name is declared. The
+// output is in input order whatever the number of jobs.
+void processFindSymbols(const std::vector<std::string>& filenames, const std::string& language,
+                        bool detectLanguages, const std::vector<std::string>& names, size_t jobs,
+                        const std::string& configFile = "") {
+    std::map<std::string, LanguageConfig> configs;
+    std::vector<const LanguageConfig*> fileConfigs;
+    for (const auto& filename : filenames) {
+        std::string fileLanguage = detectLanguages ? detectLanguage(filename, language) : language;
+        auto configIt = configs.find(fileLanguage);
+        if (configIt == configs.end()) {
+            configIt = configs.emplace(fileLanguage, getLanguageConfig(fileLanguage, configFile)).first;
+        }
+        fileConfigs.push_back(&configIt->second);
+    }
+    
+    ProjectSymbolTable project(filenames.size());
+    ThreadPool pool(jobs);
+    auto startTime = std::chrono::high_resolution_clock::now();
+    
+    pool.parallelFor(filenames.size(), [&](size_t i) {
+        const std::string& filename = filenames[i];
+        std::string source = readFile(filename);
+        auto symbolTable = std::make_shared<SymbolTable>();
+        if (!source.empty()) {
+            Lexer lexer(source, *fileConfigs[i], filename);
+            lexer.setSymbolTable(symbolTable);
+            lexer.tokenize([](const Token&) {});
+        }
+        project.addFile(i, filename, symbolTable);
+    });
+    project.finish();
+    
+    for (const auto& name : names) {
+        auto symbols = project.findSymbols(name);
+        std::cout << name << ": " << symbols.size() << (symbols.size() == 1 ? " declaration" : " declarations")
+                  << std::endl;
+        for (const auto& found : symbols) {
+            const Scope* scope = found.symbol->getScope();
+            std::cout << "  " << project.getFilename(found.file) << ":" << found.symbol->getLine() << ":"
+                      << found.symbol->getColumn() << " in " << (scope ? scope->getName() : "global")
+                      << std::endl;
+        }
+    }
+    
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    std::cout << project.symbolCount() << " symbols (" << project.nameCount() << " names) in "
+              << filenames.size() << " files in " << duration << " ms" << std::endl;
+}
+
+// Files to search: named files as given, and under directories every file
+// with a known source extension (hidden directories are skipped)
+std::vector<std::string> collectSourceFiles(const std::vector<std::string>& paths) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    
+    for (const auto& path : paths) {
+        std::error_code error;
+        if (!fs::is_directory(path, error)) {
+            files.push_back(path);
+            continue;
+        }
+        
+        std::vector<std::string> found;
+        fs::recursive_directory_iterator it(path, fs::directory_options::skip_permission_denied, error);
+        for (; !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+            const std::string name = it->path().filename().string();
+            if (it->is_directory(error)) {
+                if (name.size() > 1 && name[0] == '.') {
+                    it.disable_recursion_pending();
+                }
+            } else if (it->is_regular_file(error) && !detectLanguage(name, "").empty()) {
+                found.push_back(it->path().string());
+            }
+        }
+        std::sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
+    }
+    return files;
+}
+
+void printGrepUsage() {
+    std::cout << "Usage: lex grep [options] <pattern> [path...]" << std::endl;
+    std::cout << "Search source files for a literal string, optionally only inside tokens of" << std::endl;
+    std::cout << "given types. Directories are searched recursively (default: .)" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -t, --type <types>             Only matches inside these token types (e.g." << std::endl;
+    std::cout << "                                 identifier, strings, comments)" << std::endl;
+    std::cout << "  -w, --whole                    Only tokens whose text is exactly the pattern" << std::endl;
+    std::cout << "  -l, --language <lang>          Language for files without a known extension" << std::endl;
+    std::cout << "  -j, --jobs <n>                 Search on n threads (0 = all cores, the default)" << std::endl;
+    std::cout << "  -b, --bloom <file>             With -w and -t identifiers/keyword, skip unchanged" << std::endl;
+    std::cout << "                                 files whose identifier filter (from lex --bloom)" << std::endl;
+    std::cout << "                                 rules the pattern out" << std::endl;
+}
+
+// lex grep: token-aware literal search over files and directory trees.
+// Returns 0 if anything matched, 1 if nothing did and 2 on errors.
+int runGrep(const std::vector<std::string>& args, const std::string& configFile) {
+    std::string pattern;
+    std::vector<std::string> paths;
+    std::vector<TokenType> types;
+    std::string language = "c++";
+    bool whole = false;
+    size_t jobs = 0;
+    std::string bloomFile;
+    
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if ((arg == "-b" || arg == "--bloom") && i + 1 < args.size()) {
+            bloomFile = args[++i];
+        } else if ((arg == "-t" || arg == "--type") && i + 1 < args.size()) {
+            if (!TokenFilter::parseTypes(args[++i], types)) {
+                std::cerr << "Error: invalid token type list: " << args[i] << std::endl;
+                return 2;
+            }
+        } else if (arg == "-w" || arg == "--whole") {
+            whole = true;
+        } else if ((arg == "-l" || arg == "--language") && i + 1 < args.size()) {
+            language = args[++i];
+        } else if ((arg == "-j" || arg == "--jobs") && i + 1 < args.size()) {
+            try {
+                jobs = std::stoul(args[++i]);
+            } catch (const std::exception&) {
+                std::cerr << "Error: invalid job count: " << args[i] << std::endl;
+                return 2;
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            printGrepUsage();
+            return 0;
+        } else if (!arg.empty() && arg[0] == '-' && arg != "-") {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printGrepUsage();
+            return 2;
+        } else if (pattern.empty()) {
+            pattern = arg;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    
+    if (pattern.empty()) {
+        printGrepUsage();
+        return 2;
+    }
+    if (paths.empty()) {
+        paths.push_back(".");
+    }
+    
+    CodeSearch search(pattern);
+    search.setTypes(types);
+    search.setWholeToken(whole);
+    
+    std::vector<std::string> files = collectSourceFiles(paths);
+    
+    // A whole-token search restricted to identifiers and keywords can skip
+    // the files whose filter rules it out, as long as they have not changed
+    // since. Without -t, strings and comments could match too.
+    bool identifierSearch = !types.empty() && !pattern.empty() && !std::isdigit(static_cast<unsigned char>(pattern[0])) &&
+        std::all_of(pattern.begin(), pattern.end(), [](unsigned char c) { return std::isalnum(c) || c == '_'; }) &&
+        std::all_of(types.begin(), types.end(), [](TokenType type) {
+            return type == TokenType::IDENTIFIER || type == TokenType::KEYWORD;
+        });
+    if (!bloomFile.empty() && whole && identifierSearch) {
+        BloomIndex bloom;
+        if (!bloom.open(bloomFile)) {
+            std::cerr << "Error: " << bloom.getError() << std::endl;
+            return 2;
+        }
+        const std::vector<uint64_t> hashes = {hashBytes(pattern)};
+        std::vector<std::string> candidates;
+        for (const auto& filename : files) {
+            size_t recorded = bloom.findFile(filename);
+            if (recorded != BloomIndex::NONE && !bloom.mayContainAll(recorded, hashes)) {
+                BloomFileEntry entry = bloom.getFile(recorded);
+                XrefFile current;
+                if (statSourceFile(filename, current) && current.size == entry.size &&
+                    current.modified == entry.modified) {
+                    continue;
+                }
+            }
+            candidates.push_back(filename);
+        }
+        files.swap(candidates);
+    }
+    
+    // Configurations and span scanners per language, built up front
+    std::map<std::string, LanguageConfig> configs;
+    std::map<std::string, std::unique_ptr<Extractor>> extractors;
+    std::vector<std::pair<const LanguageConfig*, const Extractor*>> fileLanguages;
+    for (const auto& filename : files) {
+        std::string fileLanguage = detectLanguage(filename, language);
+        auto configIt = configs.find(fileLanguage);
+        if (configIt == configs.end()) {
+            configIt = configs.emplace(fileLanguage, getLanguageConfig(fileLanguage, configFile)).first;
+            extractors.emplace(fileLanguage, std::make_unique<Extractor>(configIt->second));
+        }
+        fileLanguages.emplace_back(&configIt->second, extractors[fileLanguage].get());
+    }
+    
+    ThreadPool pool(jobs);
+    const size_t wave = pool.size() * 4;
+    size_t matches = 0;
+    size_t unreadable = 0;
+    
+    for (size_t first = 0; first < files.size(); first += wave) {
+        std::vector<std::vector<SearchHit>> hits(std::min(wave, files.size() - first));
+        std::vector<char> failed(hits.size(), 0);
+        pool.parallelFor(hits.size(), [&](size_t i) {
+            const std::string& filename = files[first + i];
+            MappedFile file;
+            if (!file.open(filename)) {
+                // Empty files cannot be mapped but are no error
+                std::ifstream in(filename, std::ios::binary);
+                failed[i] = !in || in.peek() != std::ifstream::traits_type::eof();
+                return;
+            }
+            std::string_view source(reinterpret_cast<const char*>(file.bytes()), file.size());
+            const auto& fileLanguage = fileLanguages[first + i];
+            hits[i] = search.search(source, *fileLanguage.first, *fileLanguage.second, filename);
+        });
+        
+        for (size_t i = 0; i < hits.size(); ++i) {
+            if (failed[i]) {
+                std::cerr << "Error: could not read " << files[first + i] << std::endl;
+                ++unreadable;
+            }
+            for (const auto& hit : hits[i]) {
+                std::cout << files[first + i] << ":" << hit.line << ":" << hit.column << ": "
+                          << hit.lineText << "\n";
+            }
+            matches += hits[i].size();
+        }
+    }
+    std::cout.flush();
+    
+    if (unreadable > 0) {
+        return 2;
+    }
+    return matches > 0 ? 0 : 1;
+}
+
+void printIndexUsage() {
+    std::cout << "Usage: lex index [options] [path...]" << std::endl;
+    std::cout << "Record every identifier in the source files under path (default: .) in a" << std::endl;
+    std::cout << "cross-reference index. Files unchanged since the last run are not re-lexed." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -o, --output <file>            Index file (default: .lex-index)" << std::endl;
+    std::cout << "  --full                         Re-lex every file" << std::endl;
+    std::cout << "  -l, --language <lang>          Language for files without a known extension" << std::endl;
+    std::cout << "  -j, --jobs <n>                 Lex on n threads (0 = all cores, the default)" << std::endl;
+}
+
+int runIndex(const std::vector<std::string>& args, const std::string& configFile) {
+    std::vector<std::string> paths;
+    std::string indexFile = ".lex-index";
+    std::string language = "c++";
+    bool full = false;
+    size_t jobs = 0;
+    
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if ((arg == "-o" || arg == "--output") && i + 1 < args.size()) {
+            indexFile = args[++i];
+        } else if (arg == "--full") {
+            full = true;
+        } else if ((arg == "-l" || arg == "--language") && i + 1 < args.size()) {
+            language = args[++i];
+        } else if ((arg == "-j" || arg == "--jobs") && i + 1 < args.size()) {
+            try {
+                jobs = std::stoul(args[++i]);
+            } catch (const std::exception&) {
+                std::cerr << "Error: invalid job count: " << args[i] << std::endl;
+                return 2;
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            printIndexUsage();
+            return 0;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printIndexUsage();
+            return 2;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        paths.push_back(".");
+    }
+    auto startTime = std::chrono::high_resolution_clock::now();
+    
+    std::vector<XrefFile> files;
+    for (const auto& path : collectSourceFiles(paths)) {
+        XrefFile file;
+        if (statSourceFile(path, file)) {
+            files.push_back(file);
+        }
+    }
+    
+    // Files whose size and time match the previous index keep their entries
+    XrefIndex previous;
+    std::vector<uint32_t> newIds;
+    std::vector<bool> reused(files.size(), false);
+    if (!full && previous.open(indexFile)) {
+        std::unordered_map<std::string, size_t> current;
+        for (size_t i = 0; i < files.size(); ++i) {
+            current.emplace(files[i].path, i);
+        }
+        newIds.assign(previous.fileCount(), UINT32_MAX);
+        for (size_t old = 0; old < previous.fileCount(); ++old) {
+            XrefFile indexed = previous.getFile(old);
+            auto it = current.find(indexed.path);
+            if (it != current.end() && files[it->second].size == indexed.size &&
+                files[it->second].modified == indexed.modified) {
+                newIds[old] = static_cast<uint32_t>(it->second);
+                reused[it->second] = true;
+            }
+        }
+    }
+    
+    std::map<std::string, LanguageConfig> configs;
+    std::vector<const LanguageConfig*> fileConfigs(files.size(), nullptr);
+    std::vector<size_t> changed;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (reused[i]) {
+            continue;
+        }
+        std::string fileLanguage = detectLanguage(files[i].path, language);
+        auto configIt = configs.find(fileLanguage);
+        if (configIt == configs.end()) {
+            configIt = configs.emplace(fileLanguage, getLanguageConfig(fileLanguage, configFile)).first;
+        }
+        fileConfigs[i] = &configIt->second;
+        changed.push_back(i);
+    }
+    
+    // Every file is registered in input order so ids are stable; changed
+    // files are lexed in parallel and their occurrences added afterwards
+    XrefIndexBuilder builder;
+    std::vector<XrefFileOccurrences> found(files.size());
+    ThreadPool pool(jobs);
+    pool.parallelFor(changed.size(), [&](size_t i) {
+        const size_t index = changed[i];
+        std::string source = readFile(files[index].path);
+        found[index] = XrefFileOccurrences::collect(source, *fileConfigs[index], files[index].path);
+    });
+    for (size_t i = 0; i < files.size(); ++i) {
+        builder.addFile(files[i], found[i]);
+        found[i] = XrefFileOccurrences();
+    }
+    
+    for (size_t name = 0; name < previous.nameCount(); ++name) {
+        const std::string_view text = previous.name(name);
+        bool corrupt = false;
+        for (XrefOccurrence occurrence : previous.occurrences(name, &corrupt)) {
+            if (newIds[occurrence.file] != UINT32_MAX) {
+                occurrence.file = newIds[occurrence.file];
+                builder.add(text, occurrence);
+            }
+        }
+        if (corrupt) {
+            std::cerr << "Error: " << indexFile << " is corrupt (rebuild it with --full)" << std::endl;
+            return 2;
+        }
+    }
+    previous.close();
+    
+    std::string error;
+    if (!builder.write(indexFile, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 2;
+    }
+    
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    std::cout << "Indexed " << files.size() << " files (" << changed.size() << " lexed, "
+              << files.size() - changed.size() << " unchanged): " << builder.occurrenceCount()
+              << " occurrences of " << builder.nameCount() << " names in " << duration << " ms" << std::endl;
+    return 0;
+}
+
+void printXrefUsage() {
+    std::cout << "Usage: lex xref [options] <name>..." << std::endl;
+    std::cout << "Print where identifiers occur, from an index built by lex index." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -i, --index <file>             Index file (default: .lex-index)" << std::endl;
+    std::cout << "  -d, --declarations             Only declarations" << std::endl;
+}
+
+int runXref(const std::vector<std::string>& args) {
+    std::vector<std::string> names;
+    std::string indexFile = ".lex-index";
+    bool declarationsOnly = false;
+    
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if ((arg == "-i" || arg == "--index") && i + 1 < args.size()) {
+            indexFile = args[++i];
+        } else if (arg == "-d" || arg == "--declarations") {
+            declarationsOnly = true;
+        } else if (arg == "-h" || arg == "--help") {
+            printXrefUsage();
+            return 0;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printXrefUsage();
+            return 2;
+        } else {
+            names.push_back(arg);
+        }
+    }
+    if (names.empty()) {
+        printXrefUsage();
+        return 2;
+    }
+    
+    XrefIndex index;
+    if (!index.open(indexFile)) {
+        std::cerr << "Error: " << index.getError() << " (run lex index first)" << std::endl;
+        return 2;
+    }
+    
+    std::vector<std::string> paths(index.fileCount());
+    size_t matches = 0;
+    for (const auto& name : names) {
+        bool corrupt = false;
+        std::vector<XrefOccurrence> found = index.find(name, &corrupt);
+        if (corrupt) {
+            std::cerr << "Error: " << indexFile << " is corrupt (rebuild it with lex index --full)" << std::endl;
+            return 2;
+        }
+        for (const auto& occurrence : found) {
+            if (declarationsOnly && !occurrence.declaration) {
+                continue;
+            }
+            std::string& path = paths[occurrence.file];
+            if (path.empty()) {
+                path = index.getFile(occurrence.file).path;
+            }
+            std::cout << path << ":" << occurrence.line << ":" << occurrence.column << ": " << name
+                      << (occurrence.declaration ? " (declaration)" : "") << "\n";
+            ++matches;
+        }
+    }
+    std::cout.flush();
+    
+    return matches > 0 ? 0 : 1;
+}
+
+void printTagsUsage() {
+    std::cout << "Usage: lex tags [options] [path...]" << std::endl;
+    std::cout << "Write a tag file for the symbols in the source files under path (default: .)" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -e, --etags                    Write Emacs etags (default: vi ctags)" << std::endl;
+    std::cout << "  -o, --output <file>            Tag file (default: tags, or TAGS with -e; '-' for" << std::endl;
+    std::cout << "                                 stdout)" << std::endl;
+    std::cout << "  --sort-memory <MB>             Memory for sorting before runs go to disk" << std::endl;
+    std::cout << "                                 (default 256)" << std::endl;
+    std::cout << "  -l, --language <lang>          Language for files without a known extension" << std::endl;
+    std::cout << "  -j, --jobs <n>                 Lex on n threads (0 = all cores, the default)" << std::endl;
+}
+
+int runTags(const std::vector<std::string>& args, const std::string& configFile) {
+    std::vector<std::string> paths;
+    std::string tagFile;
+    std::string language = "c++";
+    TagFormat format = TagFormat::CTAGS;
+    size_t sortMemory = 256;
+    size_t jobs = 0;
+    
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "-e" || arg == "--etags") {
+            format = TagFormat::ETAGS;
+        } else if ((arg == "-o" || arg == "--output") && i + 1 < args.size()) {
+            tagFile = args[++i];
+        } else if ((arg == "-l" || arg == "--language") && i + 1 < args.size()) {
+            language = args[++i];
+        } else if (arg == "--sort-memory" && i + 1 < args.size()) {
+            try {
+                sortMemory = std::stoul(args[++i]);
+            } catch (const std::exception&) {
+                std::cerr << "Error: invalid memory size: " << args[i] << std::endl;
+                return 2;
+            }
+        } else if ((arg == "-j" || arg == "--jobs") && i + 1 < args.size()) {
+            try {
+                jobs = std::stoul(args[++i]);
+            } catch (const std::exception&) {
+                std::cerr << "Error: invalid job count: " << args[i] << std::endl;
+                return 2;
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            printTagsUsage();
+            return 0;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printTagsUsage();
+            return 2;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        paths.push_back(".");
+    }
+    if (tagFile.empty()) {
+        tagFile = format == TagFormat::ETAGS ? "TAGS" : "tags";
+    }
+    const bool toStdout = tagFile == "-";
+    auto startTime = std::chrono::high_resolution_clock::now();
+    
+    std::vector<std::string> files = collectSourceFiles(paths);
+    std::map<std::string, LanguageConfig> configs;
+    std::vector<const LanguageConfig*> fileConfigs;
+    for (const auto& filename : files) {
+        std::string fileLanguage = detectLanguage(filename, language);
+        auto configIt = configs.find(fileLanguage);
+        if (configIt == configs.end()) {
+            configIt = configs.emplace(fileLanguage, getLanguageConfig(fileLanguage, configFile)).first;
+        }
+        fileConfigs.push_back(&configIt->second);
+    }
+    
+    // Every task lexes a slice of the files and sorts its tags into a run.
+    // Runs go next to the output, or for stdout into the temporary
+    // directory under a per-process name so concurrent runs do not collide.
+    std::string runPrefix = tagFile + ".run";
+    if (toStdout) {
+        std::error_code tempError;
+        std::filesystem::path tempDirectory = std::filesystem::temp_directory_path(tempError);
+        if (tempError) {
+            tempDirectory = ".";
+        }
+        runPrefix = (tempDirectory / ("lex-tags." + std::to_string(::getpid()) + ".run")).string();
+    }
+    TagSorter sorter(format, runPrefix, std::max<size_t>(sortMemory, 1) << 20);
+    ThreadPool pool(jobs);
+    const size_t slice = 64;
+    const size_t tasks = (files.size() + slice - 1) / slice;
+    std::vector<std::string> errors(tasks);
+    pool.parallelFor(tasks, [&](size_t task) {
+        std::vector<TagEntry> run;
+        for (size_t i = task * slice; i < std::min(files.size(), (task + 1) * slice); ++i) {
+            std::string source = readFile(files[i]);
+            auto tags = collectTags(source, *fileConfigs[i], files[i], static_cast<uint32_t>(i), format);
+            run.insert(run.end(), std::make_move_iterator(tags.begin()), std::make_move_iterator(tags.end()));
+        }
+        sorter.addRun(std::move(run), errors[task]);
+    });
+    for (const auto& error : errors) {
+        if (!error.empty()) {
+            std::cerr << "Error: " << error << std::endl;
+            return 2;
+        }
+    }
+    
+    std::string error;
+    bool written;
+    if (toStdout) {
+        written = sorter.write(std::cout, files, error);
+    } else {
+        const std::string temporary = tagFile + ".tmp";
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        written = out && sorter.write(out, files, error);
+        out.close();
+        if (written && std::rename(temporary.c_str(), tagFile.c_str()) != 0) {
+            error = "could not replace " + tagFile;
+            written = false;
+        }
+        if (!written) {
+            std::remove(temporary.c_str());
+            if (error.empty()) {
+                error = "could not create " + temporary;
+            }
+        }
+    }
+    if (!written) {
+        std::cerr << "Error: " << error << std::endl;
+        return 2;
+    }
+    
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    (toStdout ? std::cerr : std::cout) << "Wrote " << sorter.tagCount() << " tags for " << files.size()
+                                       << " files (" << sorter.runCount() << " runs, " << sorter.spilledCount()
+                                       << " on disk) in " << duration << " ms" << std::endl;
+    return 0;
+}
+
+void printCandidatesUsage() {
+    std::cout << "Usage: lex candidates [options] <name>..." << std::endl;
+    std::cout << "List the files that may contain every one of the identifiers, from the" << std::endl;
+    std::cout << "Bloom filters recorded by lex --bloom. Other files certainly do not." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -b, --bloom <file>             Sidecar file (default: .lex-bloom)" << std::endl;
+    std::cout << "  --verify                       Also list files changed since they were recorded" << std::endl;
+}
+
+int runCandidates(const std::vector<std::string>& args) {
+    std::vector<std::string> names;
+    std::string bloomFile = ".lex-bloom";
+    bool verify = false;
+    
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if ((arg == "-b" || arg == "--bloom") && i + 1 < args.size()) {
+            bloomFile = args[++i];
+        } else if (arg == "--verify") {
+            verify = true;
+        } else if (arg == "-h" || arg == "--help") {
+            printCandidatesUsage();
+            return 0;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printCandidatesUsage();
+            return 2;
+        } else {
+            names.push_back(arg);
+        }
+    }
+    if (names.empty()) {
+        printCandidatesUsage();
+        return 2;
+    }
+    
+    BloomIndex index;
+    if (!index.open(bloomFile)) {
+        std::cerr << "Error: " << index.getError() << " (run lex --bloom first)" << std::endl;
+        return 2;
+    }
+    
+    auto startTime = std::chrono::high_resolution_clock::now();
+    std::vector<size_t> candidates = index.candidates(names);
+    
+    // A filter only describes the contents it was built from: with --verify,
+    // files ruled out are checked for changes and kept if they have any
+    if (verify) {
+        std::vector<size_t> changed;
+        size_t next = 0;
+        for (size_t i = 0; i < index.fileCount(); ++i) {
+            if (next < candidates.size() && candidates[next] == i) {
+                ++next;
+                continue;
+            }
+            BloomFileEntry recorded = index.getFile(i);
+            XrefFile current;
+            if (statSourceFile(recorded.path, current) &&
+                (current.size != recorded.size || current.modified != recorded.modified)) {
+                changed.push_back(i);
             }
         }
+        std::vector<size_t> merged;
+        std::merge(candidates.begin(), candidates.end(), changed.begin(), changed.end(), std::back_inserter(merged));
+        candidates.swap(merged);
+    }
+    
+    for (size_t file : candidates) {
+        std::cout << index.getFile(file).path << "\n";
     }
+    std::cout.flush();
+    
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+    std::cerr << candidates.size() << " of " << index.fileCount() << " files are candidates (" << duration
+              << " us)" << std::endl;
+    return candidates.empty() ? 1 : 0;
 }
 
 void interactiveMode(const std::string& language = "cpp", const std::string& configFile = "") {
@@ -276,15 +1588,54 @@ void exportLanguageConfig(const std::string& language, const std::string& filena
 }
 
 void printUsage() {
-    std::cout << "Usage: lex [options] [file]" << std::endl;
+    std::cout << "Usage: lex [options] [file...]" << std::endl;
+    std::cout << "       lex grep [options] <pattern> [path...]   (see lex grep --help)" << std::endl;
+    std::cout << "       lex index [options] [path...]            (see lex index --help)" << std::endl;
+    std::cout << "       lex xref [options] <name>...             (see lex xref --help)" << std::endl;
+    std::cout << "       lex tags [options] [path...]             (see lex tags --help)" << std::endl;
+    std::cout << "       lex candidates [options] <name>...       (see lex candidates --help)" << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout << "  -i, --interactive              Start in interactive mode" << std::endl;
     std::cout << "  -l, --language <lang>          Specify language from available plugins" << std::endl;
     std::cout << "  -c, --config <file>            Use custom language configuration file" << std::endl;
     std::cout << "  -p, --plugins-dir <dir>        Specify plugins directory (default: ./plugins)" << std::endl;
     std::cout << "  -v, --verbose                  Show detailed token information" << std::endl;
-    std::cout << "  -e, --export <format>          Export tokens in format (json, xml, csv, html)" << std::endl;
-    std::cout << "  -o, --output <file>            Output file for export" << std::endl;
+    std::cout << "  -e, --export <format[:file]>   Export tokens in format (json, json-columnar, ndjson," << std::endl;
+    std::cout << "                                 ndjson-files, xml, csv, html, html-pages, binary);" << std::endl;
+    std::cout << "                                 repeat to write several formats in one pass" << std::endl;
+    std::cout << "  -o, --output <file>            Output file for an export without ':file' ('-' for stdout)" << std::endl;
+    std::cout << "  --fields <list>                Export only these fields (type, lexeme, line," << std::endl;
+    std::cout << "                                 column, filename, attributes)" << std::endl;
+    std::cout << "  --drop <types>                 Skip tokens of these types while lexing (e.g." << std::endl;
+    std::cout << "                                 comment,preprocessor; also blank, numbers, strings," << std::endl;
+    std::cout << "                                 operators, delimiters)" << std::endl;
+    std::cout << "  --extract <kinds>              Only extract comments, docs and/or strings, without" << std::endl;
+    std::cout << "                                 tokenizing (printed, or exported with -e)" << std::endl;
+    std::cout << "  --patterns <file>              Report occurrences of the literal strings in file" << std::endl;
+    std::cout << "                                 (one per line) found while lexing" << std::endl;
+    std::cout << "  --scan-types <types>           Token types searched for patterns (default:" << std::endl;
+    std::cout << "                                 strings,comments,identifiers)" << std::endl;
+    std::cout << "  --brackets                     Match ( ) [ ] { } while lexing and report" << std::endl;
+    std::cout << "                                 unbalanced delimiters" << std::endl;
+    std::cout << "  --symbols <mode>               Build the symbol table inline (default for one" << std::endl;
+    std::cout << "                                 file), deferred on another thread, or off" << std::endl;
+    std::cout << "  --scope-at <line:column>       Show the scopes enclosing a position and the" << std::endl;
+    std::cout << "                                 symbols visible there (single file)" << std::endl;
+    std::cout << "  --complete <prefix>            List symbol names starting with prefix (single" << std::endl;
+    std::cout << "                                 file)" << std::endl;
+    std::cout << "  --fuzzy <text>                 List the symbol names most like text (single file)" << std::endl;
+    std::cout << "  --find-symbol <name>           Print where a name is declared across all files" << std::endl;
+    std::cout << "                                 (lexed on -j threads; repeatable)" << std::endl;
+    std::cout << "  --query <query>                Print token sequences matching a query, e.g." << std::endl;
+    std::cout << "                                 \"'if' '(' IDENTIFIER ')'\" or \"'new' *{0,8} ';'\"" << std::endl;
+    std::cout << "  --bloom <file>                 Record a Bloom filter of each file's identifiers in" << std::endl;
+    std::cout << "                                 a sidecar for lex candidates and lex grep -b" << std::endl;
+    std::cout << "  --page-lines <n>               Lines per page for html-pages (default 1000)" << std::endl;
+    std::cout << "  -j, --jobs <n>                 Format exports on n threads (0 = all cores); with" << std::endl;
+    std::cout << "                                 several exports, each gets its own thread" << std::endl;
+    std::cout << "  --dataset <dir>                Write token id, type and position arrays plus a" << std::endl;
+    std::cout << "                                 vocabulary for ML training (lexed on -j threads)" << std::endl;
+    std::cout << "  --dataset-format <fmt>         Dataset array format: npy (default) or raw" << std::endl;
     std::cout << "  --export-config <lang> <file>  Export language config to a JSON file" << std::endl;
     std::cout << "  --list-plugins                 List available language plugins" << std::endl;
     std::cout << "  -h, --help                     Display this help message" << std::endl;
@@ -293,6 +1644,14 @@ void printUsage() {
 }
 
 int main(int argc, char* argv[]) {
+    // Index queries only read the index, so they skip the plugin scan
+    if (argc > 1 && std::string(argv[1]) == "xref") {
+        return runXref(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 1 && std::string(argv[1]) == "candidates") {
+        return runCandidates(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    
     // Initialize the plugin manager and scan for language plugins
     auto& pluginManager = LanguagePluginManager::getInstance();
     pluginManager.scanForPlugins();
@@ -310,14 +1669,41 @@ int main(int argc, char* argv[]) {
         return 0;
     }
     
+    // Subcommands
+    if (std::string(argv[1]) == "grep") {
+        return runGrep(std::vector<std::string>(argv + 2, argv + argc), "");
+    }
+    if (std::string(argv[1]) == "tags") {
+        return runTags(std::vector<std::string>(argv + 2, argv + argc), "");
+    }
+    if (std::string(argv[1]) == "index") {
+        return runIndex(std::vector<std::string>(argv + 2, argv + argc), "");
+    }
+    
     // Process command line arguments
-    std::string filename;
+    std::vector<std::string> filenames;
     std::string language = "c++"; // Default language (will be mapped to cpp)
     std::string configFile;
     std::string pluginsDir;
     bool verbose = false;
-    std::string exportFormat;
-    std::string exportFile;
+    ExportOptions exportOptions;
+    std::string outputFile;
+    std::string datasetDir;
+    TokenFilter tokenFilter;
+    Extractor::Kinds extractKinds = 0;
+    std::string patternFile;
+    std::string scanTypes = "strings,comments,identifiers";
+    bool scanTypesSet = false;
+    std::string queryText;
+    std::vector<std::string> findNames;
+    std::string bloomFile;
+    std::string completePrefix;
+    std::string fuzzyQuery;
+    bool checkBrackets = false;
+    std::pair<int, int> scopeAt(0, 0);
+    SymbolMode symbolMode = SymbolMode::INLINE;
+    bool symbolModeSet = false;
+    DatasetWriter::Format datasetFormat = DatasetWriter::Format::NPY;
     bool interactive = false;
     bool exportConfig = false;
     std::string exportConfigLang;
@@ -358,18 +1744,167 @@ int main(int argc, char* argv[]) {
             }
         } else if (arg == "-e" || arg == "--export") {
             if (i + 1 < argc) {
-                exportFormat = argv[++i];
+                // FORMAT:PATH names its own output; a plain FORMAT uses -o
+                std::string spec = argv[++i];
+                size_t colon = spec.find(':');
+                if (colon == std::string::npos) {
+                    exportOptions.targets.push_back({spec, ""});
+                } else {
+                    exportOptions.targets.push_back({spec.substr(0, colon), spec.substr(colon + 1)});
+                }
             } else {
                 std::cerr << "Error: --export requires an argument" << std::endl;
                 return 1;
             }
         } else if (arg == "-o" || arg == "--output") {
             if (i + 1 < argc) {
-                exportFile = argv[++i];
+                outputFile = argv[++i];
             } else {
                 std::cerr << "Error: --output requires an argument" << std::endl;
                 return 1;
             }
+        } else if (arg == "--fields") {
+            if (i + 1 < argc) {
+                if (!ExportField::parse(argv[++i], exportOptions.fields)) {
+                    std::cerr << "Error: invalid field list: " << argv[i] << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --fields requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--page-lines") {
+            if (i + 1 < argc) {
+                try {
+                    exportOptions.pageLines = std::stoul(argv[++i]);
+                } catch (const std::exception&) {
+                    std::cerr << "Error: --page-lines requires a number" << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --page-lines requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "-j" || arg == "--jobs") {
+            if (i + 1 < argc) {
+                try {
+                    exportOptions.jobs = std::stoul(argv[++i]);
+                } catch (const std::exception&) {
+                    std::cerr << "Error: --jobs requires a number" << std::endl;
+                    return 1;
+                }
+                if (exportOptions.jobs == 0) {
+                    exportOptions.jobs = ThreadPool::hardwareThreads();
+                }
+            } else {
+                std::cerr << "Error: --jobs requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--drop") {
+            if (i + 1 < argc) {
+                if (!TokenFilter::parse(argv[++i], tokenFilter)) {
+                    std::cerr << "Error: invalid token type list: " << argv[i] << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --drop requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--symbols") {
+            if (i + 1 < argc && parseSymbolMode(argv[i + 1], symbolMode)) {
+                symbolModeSet = true;
+                ++i;
+            } else {
+                std::cerr << "Error: --symbols requires off, inline or deferred" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--scope-at") {
+            char separator = 0;
+            std::istringstream position(i + 1 < argc ? argv[++i] : "");
+            if (!(position >> scopeAt.first >> separator >> scopeAt.second) || separator != ':' ||
+                scopeAt.first < 1 || scopeAt.second < 1) {
+                std::cerr << "Error: --scope-at requires a position as line:column" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--brackets") {
+            checkBrackets = true;
+        } else if (arg == "--complete") {
+            if (i + 1 < argc) {
+                completePrefix = argv[++i];
+            } else {
+                std::cerr << "Error: --complete requires a prefix" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--fuzzy") {
+            if (i + 1 < argc) {
+                fuzzyQuery = argv[++i];
+            } else {
+                std::cerr << "Error: --fuzzy requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--bloom") {
+            if (i + 1 < argc) {
+                bloomFile = argv[++i];
+            } else {
+                std::cerr << "Error: --bloom requires a file" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--find-symbol") {
+            if (i + 1 < argc) {
+                findNames.push_back(argv[++i]);
+            } else {
+                std::cerr << "Error: --find-symbol requires a name" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--query") {
+            if (i + 1 < argc) {
+                queryText = argv[++i];
+            } else {
+                std::cerr << "Error: --query requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--patterns") {
+            if (i + 1 < argc) {
+                patternFile = argv[++i];
+            } else {
+                std::cerr << "Error: --patterns requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--scan-types") {
+            if (i + 1 < argc) {
+                scanTypes = argv[++i];
+                scanTypesSet = true;
+            } else {
+                std::cerr << "Error: --scan-types requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--extract") {
+            if (i + 1 < argc) {
+                if (!Extractor::parseKinds(argv[++i], extractKinds)) {
+                    std::cerr << "Error: invalid extract list: " << argv[i] << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --extract requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--dataset") {
+            if (i + 1 < argc) {
+                datasetDir = argv[++i];
+            } else {
+                std::cerr << "Error: --dataset requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--dataset-format") {
+            if (i + 1 < argc) {
+                if (!DatasetWriter::parseFormat(argv[++i], datasetFormat)) {
+                    std::cerr << "Error: unknown dataset format: " << argv[i] << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --dataset-format requires an argument" << std::endl;
+                return 1;
+            }
         } else if (arg == "--export-config") {
             if (i + 2 < argc) {
                 exportConfig = true;
@@ -382,7 +1917,7 @@ int main(int argc, char* argv[]) {
         } else if (arg == "--list-plugins") {
             listPlugins = true;
         } else if (arg[0] != '-') {
-            filename = arg;
+            filenames.push_back(arg);
         } else {
             std::cerr << "Unknown option: " << arg << std::endl;
             printUsage();
@@ -390,6 +1925,25 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    // Give -o to the export that didn't name a path; an export with no
+    // output at all is ignored as before
+    std::vector<ExportTarget> targets;
+    bool outputUsed = false;
+    for (auto& target : exportOptions.targets) {
+        if (target.file.empty() && !outputFile.empty()) {
+            if (outputUsed) {
+                std::cerr << "Error: -o can only be shared by one export; use FORMAT:PATH" << std::endl;
+                return 1;
+            }
+            target.file = outputFile;
+            outputUsed = true;
+        }
+        if (!target.file.empty()) {
+            targets.push_back(target);
+        }
+    }
+    exportOptions.targets = std::move(targets);
+    
     if (listPlugins) {
         auto languages = pluginManager.getAvailableLanguages();
         
@@ -414,21 +1968,107 @@ int main(int argc, char* argv[]) {
         return 0;
     }
     
-    if (!filename.empty()) {
+    // Patterns are scanned in the token loop of single-file and batch runs;
+    // the other modes have no place for them
+    if (scanTypesSet && patternFile.empty()) {
+        std::cerr << "Error: --scan-types requires --patterns" << std::endl;
+        return 1;
+    }
+    if (!patternFile.empty() &&
+        (!findNames.empty() || !queryText.empty() || extractKinds != 0 || !datasetDir.empty())) {
+        std::cerr << "Error: --patterns cannot be combined with --find-symbol, --query, --extract or --dataset"
+                  << std::endl;
+        return 1;
+    }
+    
+    // Extraction scans spans without tokenizing and --find-symbol reads
+    // symbol tables filled before any filter, so neither can drop tokens
+    if (!tokenFilter.isEmpty() && (!findNames.empty() || extractKinds != 0)) {
+        std::cerr << "Error: --drop cannot be combined with --find-symbol or --extract" << std::endl;
+        return 1;
+    }
+    
+    // --scope-at, --complete and --fuzzy read the symbol table of a
+    // single-file run. Deferred tables are built from the tokens --drop
+    // leaves, so they need them all.
+    std::string symbolQuery;
+    if (scopeAt.first > 0) {
+        symbolQuery = "--scope-at";
+    } else if (!completePrefix.empty()) {
+        symbolQuery = "--complete";
+    } else if (!fuzzyQuery.empty()) {
+        symbolQuery = "--fuzzy";
+    }
+    if (!symbolQuery.empty()) {
+        if (filenames.size() != 1 || !bloomFile.empty() || !findNames.empty() || !queryText.empty() ||
+            extractKinds != 0 || !datasetDir.empty()) {
+            std::cerr << "Error: " << symbolQuery << " needs exactly one file and no --bloom, --find-symbol,"
+                      << " --query, --extract or --dataset" << std::endl;
+            return 1;
+        }
+        if (symbolMode == SymbolMode::OFF) {
+            std::cerr << "Error: " << symbolQuery << " needs the symbol table (--symbols inline or deferred)"
+                      << std::endl;
+            return 1;
+        }
+        if (symbolMode == SymbolMode::DEFERRED && !tokenFilter.isEmpty()) {
+            std::cerr << "Error: " << symbolQuery << " with --symbols deferred cannot be combined with --drop"
+                      << std::endl;
+            return 1;
+        }
+    }
+    
+    // Patterns are compiled once and matched while lexing
+    std::unique_ptr<PatternScan> patterns;
+    if (!patternFile.empty()) {
+        std::vector<TokenType> types;
+        if (!TokenFilter::parseTypes(scanTypes, types)) {
+            std::cerr << "Error: invalid token type list: " << scanTypes << std::endl;
+            return 1;
+        }
+        patterns = std::make_unique<PatternScan>();
+        if (!patterns->matcher.loadFile(patternFile)) {
+            std::cerr << "Could not open pattern file: " << patternFile << std::endl;
+            return 1;
+        }
+        patterns->matcher.compile();
+        patterns->types.keepOnly(types);
+    }
+    
+    if (!findNames.empty() && !filenames.empty()) {
+        bool detectLanguages = language.empty() || language == "c++";
+        processFindSymbols(filenames, language, detectLanguages, findNames, exportOptions.jobs, configFile);
+    } else if (!queryText.empty() && !filenames.empty()) {
+        TokenQuery query;
+        std::string error;
+        if (!TokenQuery::parse(queryText, query, error)) {
+            std::cerr << "Error: invalid query: " << error << std::endl;
+            return 1;
+        }
+        bool detectLanguages = language.empty() || language == "c++";
+        processQuery(filenames, language, detectLanguages, query, exportOptions.jobs, configFile, tokenFilter);
+    } else if (extractKinds != 0 && !filenames.empty()) {
+        bool detectLanguages = language.empty() || language == "c++";
+        processExtract(filenames, language, detectLanguages, extractKinds, exportOptions, configFile);
+    } else if (!datasetDir.empty() && !filenames.empty()) {
+        bool detectLanguages = language.empty() || language == "c++";
+        processDataset(filenames, language, detectLanguages, datasetDir, datasetFormat,
+                       exportOptions.jobs, configFile, tokenFilter);
+    } else if (filenames.size() == 1 && bloomFile.empty()) {
+        const std::string& filename = filenames.front();
+        
         // If no language specified, try to guess from file extension
         if (language.empty() || language == "c++") {
-            size_t dotPos = filename.find_last_of('.');
-            if (dotPos != std::string::npos) {
-                std::string ext = filename.substr(dotPos + 1);
-                if (ext == "c") language = "c";
-                else if (ext == "cpp" || ext == "cc" || ext == "cxx" || ext == "hpp" || ext == "h") language = "c++";
-                else if (ext == "java") language = "java";
-                else if (ext == "py") language = "python";
-                else if (ext == "js") language = "javascript";
-            }
+            language = detectLanguage(filename, language);
         }
         
-        processFile(filename, language, verbose, exportFormat, exportFile, configFile);
+        processFile(filename, language, verbose, exportOptions, configFile, tokenFilter, patterns.get(),
+                    checkBrackets, scopeAt, symbolMode, completePrefix, fuzzyQuery);
+    } else if (!filenames.empty()) {
+        bool detectLanguages = language.empty() || language == "c++";
+        // Batch runs never show symbols, so they skip them unless asked
+        processBatch(filenames, language, detectLanguages, exportOptions, configFile, tokenFilter,
+                     patterns.get(), checkBrackets, symbolModeSet ? symbolMode : SymbolMode::OFF, bloomFile);
     } else {
         std::cerr << "No input file specified" << std::endl;
         printUsage();
@@ -8,6 +8,8 @@
 #include "LanguagePlugin.h"
 #include "Token.h"
 #include "ConfigLoader.h"
+#include "Escape.h"
+#include "ExportFormatter.h"
 
 // Function to initialize plugin system
 void initializePlugins() {
@@ -56,35 +58,77 @@ void initializePlugins() {
 
 // Helper function to escape JSON strings
 std::string escapeJsonString(const std::string& input) {
-    std::string output;
-    output.reserve(input.length());
+    return Escape::escape(input, Escape::Format::JSON);
+}
+
+// Storage for custom runtime-registered languages
+std::map<std::string, LanguageConfig> customLanguages;
+
+// Resolve a language id to a configuration: runtime-registered languages
+// first, then plugins (with common aliases), falling back to C
+LanguageConfig resolveLanguageConfig(const std::string& langId) {
+    LanguageConfig config;
     
-    for (char c : input) {
-        switch (c) {
-            case '\"': output += "\\\""; break;
-            case '\\': output += "\\\\"; break;
-            case '\b': output += "\\b"; break;
-            case '\f': output += "\\f"; break;
-            case '\n': output += "\\n"; break;
-            case '\r': output += "\\r"; break;
-            case '\t': output += "\\t"; break;
-            default:
-                if (static_cast<unsigned char>(c) < 0x20) {
-                    char buf[7];
-                    snprintf(buf, sizeof(buf), "\\u%04x", c);
-                    output += buf;
-                } else {
-                    output += c;
+    // First check custom runtime-registered languages
+    auto customLangIt = customLanguages.find(langId);
+    if (customLangIt != customLanguages.end()) {
+        config = customLangIt->second;
+    } else {
+        // Debug info about the requested language
+        printf("Tokenizing with language: %s\n", langId.c_str());
+        
+        // Handle some common aliases - we need to match the file names
+        std::string langKey = langId;
+        
+        // Map to actual plugin file names
+        // File pattern is {key}_config.json
+        if (langId == "c++") langKey = "cpp";
+        if (langId == "py") langKey = "python";  
+        if (langId == "javascript") langKey = "js";
+        
+        printf("Mapped to plugin key: %s (looking for %s_config.json)\n", langKey.c_str(), langKey.c_str());
+        
+        // Check if there's a plugin
+        auto& pluginManager = LanguagePluginManager::getInstance();
+        if (pluginManager.hasLanguage(langKey)) {
+            config = pluginManager.loadLanguage(langKey);
+            printf("Successfully loaded plugin for %s\n", langKey.c_str());
+        } else {
+            // Try with different mappings if first attempt failed
+            printf("Plugin %s not found, trying alternatives...\n", langKey.c_str());
+            
+            // If c++ didn't work, try cpp
+            if (langId == "c++") {
+                printf("Trying 'cpp' instead of 'c++'\n");
+                if (pluginManager.hasLanguage("cpp")) {
+                    config = pluginManager.loadLanguage("cpp");
+                    printf("Successfully loaded plugin for cpp\n");
+                }
+            }
+            
+            // If javascript didn't work, try js
+            if (langId == "javascript") {
+                printf("Trying 'js' instead of 'javascript'\n");
+                if (pluginManager.hasLanguage("js")) {
+                    config = pluginManager.loadLanguage("js");
+                    printf("Successfully loaded plugin for js\n");
                 }
+            }
+            
+            // Default to C if not found
+            try {
+                printf("Falling back to 'c' plugin\n");
+                config = pluginManager.loadLanguage("c");
+            } catch (...) {
+                printf("No fallback plugin available\n");
+                throw std::runtime_error("No language plugins available");
+            }
         }
     }
     
-    return output;
+    return config;
 }
 
-// Storage for custom runtime-registered languages
-std::map<std::string, LanguageConfig> customLanguages;
-
 // Exported functions need to use extern "C" to avoid name mangling
 extern "C" {
 
@@ -134,68 +178,14 @@ char* tokenizeString(const char* sourceCode, const char* languageId) {
     
     try {
         // Get language configuration from plugins or registered languages
-        LanguageConfig config;
-        
-        // First check custom runtime-registered languages
-        auto customLangIt = customLanguages.find(langId);
-        if (customLangIt != customLanguages.end()) {
-            config = customLangIt->second;
-        } else {
-            // Debug info about the requested language
-            printf("Tokenizing with language: %s\n", langId.c_str());
-            
-            // Handle some common aliases - we need to match the file names
-            std::string langKey = langId;
-            
-            // Map to actual plugin file names
-            // File pattern is {key}_config.json
-            if (langId == "c++") langKey = "cpp";
-            if (langId == "py") langKey = "python";  
-            if (langId == "javascript") langKey = "js";
-            
-            printf("Mapped to plugin key: %s (looking for %s_config.json)\n", langKey.c_str(), langKey.c_str());
-            
-            // Check if there's a plugin
-            auto& pluginManager = LanguagePluginManager::getInstance();
-            if (pluginManager.hasLanguage(langKey)) {
-                config = pluginManager.loadLanguage(langKey);
-                printf("Successfully loaded plugin for %s\n", langKey.c_str());
-            } else {
-                // Try with different mappings if first attempt failed
-                printf("Plugin %s not found, trying alternatives...\n", langKey.c_str());
-                
-                // If c++ didn't work, try cpp
-                if (langId == "c++") {
-                    printf("Trying 'cpp' instead of 'c++'\n");
-                    if (pluginManager.hasLanguage("cpp")) {
-                        config = pluginManager.loadLanguage("cpp");
-                        printf("Successfully loaded plugin for cpp\n");
-                    }
-                }
-                
-                // If javascript didn't work, try js
-                if (langId == "javascript") {
-                    printf("Trying 'js' instead of 'javascript'\n");
-                    if (pluginManager.hasLanguage("js")) {
-                        config = pluginManager.loadLanguage("js");
-                        printf("Successfully loaded plugin for js\n");
-                    }
-                }
-                
-                // Default to C if not found
-                try {
-                    printf("Falling back to 'c' plugin\n");
-                    config = pluginManager.loadLanguage("c");
-                } catch (...) {
-                    printf("No fallback plugin available\n");
-                    throw std::runtime_error("No language plugins available");
-                }
-            }
-        }
+        LanguageConfig config = resolveLanguageConfig(langId);
         
         // Create lexer with configuration
         Lexer lexer(source, config);
         
+        // Symbols are never returned to JavaScript
+        lexer.setSymbolMode(SymbolMode::OFF);
+        
         // Get tokens
         std::vector<Token> tokens = lexer.tokenize();
         
@@ -246,6 +236,47 @@ char* tokenizeString(const char* sourceCode, const char* languageId) {
     return result;
 }
 
+// Columnar variant of tokenizeString for large inputs: "tokens" holds the
+// columnar JSON layout (typeTable/type, lexemeTable/lexeme, line, column)
+// instead of one object per token
+EMSCRIPTEN_KEEPALIVE
+char* tokenizeStringColumnar(const char* sourceCode, const char* languageId) {
+    if (!sourceCode || !languageId) {
+        return nullptr;
+    }
+    
+    std::string response;
+    
+    try {
+        LanguageConfig config = resolveLanguageConfig(languageId);
+        Lexer lexer(sourceCode, config);
+        lexer.setSymbolMode(SymbolMode::OFF);
+        
+        std::vector<Token> tokens = lexer.tokenize();
+        if (!tokens.empty() && tokens.back().type == TokenType::EOF_TOKEN) {
+            tokens.pop_back();
+        }
+        
+        ColumnarJsonExporter exporter;
+        exporter.setFields(ExportField::TYPE | ExportField::LEXEME | ExportField::LINE | ExportField::COLUMN);
+        
+        response = "{";
+        if (lexer.hasErrors()) {
+            response += "\"error\": \"" + escapeJsonString(lexer.getErrorReport()) + "\",";
+        }
+        response += "\"tokens\": ";
+        response += exporter.exportToString(tokens);
+        response += "}";
+    } catch (const std::exception& e) {
+        response = "{\"error\": \"" + escapeJsonString(e.what()) + "\", \"tokens\": null}";
+    }
+    
+    char* result = (char*)malloc(response.size() + 1);
+    memcpy(result, response.c_str(), response.size() + 1);
+    
+    return result;
+}
+
 // Function to get available language names
 EMSCRIPTEN_KEEPALIVE
 char* getLanguageNames() {
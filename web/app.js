@@ -21,7 +21,10 @@ LexModule().then(function(Module) {
     const loadingDiv = document.getElementById('loading');
     
     // Create C function wrappers
-    const tokenizeString = Module.cwrap('tokenizeString', 'string', ['string', 'string']);
+    // Prefer the compact columnar output; older builds only have tokenizeString
+    const tokenizeString = typeof Module._tokenizeStringColumnar === 'function'
+        ? Module.cwrap('tokenizeStringColumnar', 'string', ['string', 'string'])
+        : Module.cwrap('tokenizeString', 'string', ['string', 'string']);
     const getLanguageNames = Module.cwrap('getLanguageNames', 'string', []);
 
     // Populate language dropdown
@@ -130,12 +133,34 @@ LexModule().then(function(Module) {
         }
     }
 
+    // Expand the columnar token layout (parallel arrays plus type and
+    // lexeme tables) into token objects; row-per-token arrays pass through
+    function decodeColumnar(columns) {
+        if (!columns) {
+            return [];
+        }
+        if (Array.isArray(columns)) {
+            return columns;
+        }
+        const tokens = new Array(columns.count);
+        for (let i = 0; i < columns.count; i++) {
+            tokens[i] = {
+                type: columns.typeTable[columns.type[i]],
+                lexeme: columns.lexemeTable[columns.lexeme[i]],
+                line: columns.line[i],
+                column: columns.column[i]
+            };
+        }
+        return tokens;
+    }
+
     // Process tokens and display them
     function displayTokens(tokensJson, executionTime) {
         try {
             console.log('Parsing tokens JSON');
             console.log('Raw tokens JSON:', tokensJson);
-            const tokens = JSON.parse(tokensJson);
+            const response = JSON.parse(tokensJson);
+            const tokens = { error: response.error, tokens: decodeColumnar(response.tokens) };
             
             // Hide loading indicator
             loadingDiv.style.display = 'none';